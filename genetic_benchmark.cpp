@@ -0,0 +1,59 @@
+#include <fmt/format.h>
+
+#include "src/core/time.hpp"
+#include "src/machine_learning/Genetic.hpp"
+
+/*
+ * Generation turnover cost of Genetic
+ *
+ * Measures perform_new_generation() alone (selection, crossover pairs, supermutation check and mutation)
+ * for populations of 10^3 .. 10^6 with trivial chromosomes, so the bookkeeping cost is not hidden
+ * behind the cost of copying or evaluating the data.
+ *
+ * Usage: genetic_benchmark [max population] [generations]
+ */
+
+using Genome = float;
+
+int main(int argc, char* argv[]) {
+    size_t max_population = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t generations    = argc > 2 ? std::stoul(argv[2]) : 20;
+
+    auto rand_gen = std::mt19937(42);
+
+    fmt::print("{:>10}  {:>12}  {:>14}  {:>12}\n", "population", "ms/gen", "ns/individual", "gen/sec");
+
+    for (size_t population = 1000; population <= max_population; population *= 10) {
+        auto genetic = Genetic<Genome>(population);
+        auto dist    = std::uniform_real_distribution<float>(-1.f, 1.f);
+
+        genetic.seed(42);
+        genetic.init([&] { return dist(rand_gen); });
+
+        genetic.set_crossing_over_inplace_callback([](Chromosome<Genome>& a, Chromosome<Genome>& b, Genome& child) {
+            child = (a.get() + b.get()) * 0.5f;
+        });
+
+        genetic.set_mutation_callback([&](Chromosome<Genome>& chromosome, float intensity) {
+            chromosome.get() += dist(rand_gen) * intensity;
+        });
+
+        double total = 0;
+
+        for (size_t gen = 0; gen < generations; ++gen) {
+            for (auto& chromosome : genetic)
+                chromosome.fitness_factor(-std::abs(chromosome.get() - 0.5f));
+
+            auto timer = Timer();
+            genetic.perform_new_generation();
+            total += timer.tick().sec();
+        }
+
+        auto per_generation = total / double(generations);
+
+        fmt::print("{:>10}  {:>12.3f}  {:>14.1f}  {:>12.1f}\n",
+                   population, per_generation * 1e3, per_generation * 1e9 / double(population), 1.0 / per_generation);
+    }
+
+    return 0;
+}
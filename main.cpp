@@ -9,16 +9,20 @@
 #include "src/graphics/Camera.hpp"
 #include "src/graphics/CameraManipulator.hpp"
 #include "src/graphics/HUD.hpp"
+#include "src/graphics/SfmlPhysicThreadDraw.hpp"
 #include "src/EngineState.hpp"
 #include "src/game/KeyCombo.hpp"
 #include "src/game/PhysicHumanBody.hpp"
 
 #include "src/core/math.hpp"
+#include "src/core/TripleBuffer.hpp"
 #include "src/machine_learning/Neuron.hpp"
 #include <Box2D/Dynamics/Joints/b2RevoluteJoint.h>
 
 #include "src/game/RepeaterJointProcessor.hpp"
 #include "src/game/HolderJointProcessor.hpp"
+#include "src/game/SimulationRecording.hpp"
+#include "src/game/HumanSetups.hpp"
 #include "src/game/MotionInterfaces.hpp"
 
 void Engine::mainCreate() {
@@ -47,10 +51,33 @@ void Engine::mainCreate() {
     static scl::Vector2f start_pos;
     static scl::Vector2f start_pos_wnd;
     static sf::ConvexShape* shot_shape;
+    // Accessed only on the physics thread
     static std::weak_ptr<PhysicHumanBody> last_body;
 
+    // Published by the physics thread for the HUD
+    struct HumanInfo {
+        bool  valid    = false;
+        float speed    = 0.f;
+        bool  ground   = false;
+        float ground_x = 0.f;
+        float ground_y = 0.f;
+    };
+    static TripleBuffer<HumanInfo> human_info;
+
     static auto physics_callback = [wnd, camera](PhysicSimulation& it) {
+        auto& info = human_info.write_buffer();
+        info = HumanInfo();
+
         if (auto human = last_body.lock()) {
+            info.valid = true;
+            info.speed = human->velocity().magnitude();
+
+            if (auto cast = human->ground_raycast_shin_left_info()) {
+                info.ground   = true;
+                info.ground_x = cast->distance.x();
+                info.ground_y = cast->distance.y();
+            }
+
             //if (auto arm_l = human->joint_processor_cast_get<HolderJointProcessor>("arm_l").lock()) {
             //    auto cursor_pos = wnd->getMouseCoords(*camera);
             //    auto joint_pos  = human->joint_position(PhysicHumanBody::BodyJoint_Chest_ArmL);
@@ -62,6 +89,17 @@ void Engine::mainCreate() {
             //                    std::atan2(dir.x(), -dir.y()) - chest_angle) - math::angle::radian(17.f));
             //}
         }
+
+        human_info.publish();
+    };
+
+    static auto createPhysicThread = [] {
+        auto thread = std::make_unique<PhysicThread>(PhysicSimulation::createTestSimulation());
+        thread->post([](PhysicSimulation& it) {
+            it.addPostUpdateCallback("clbk", physics_callback);
+            human_setups::add_all(it);
+        });
+        return thread;
     };
 
     wnd->addRenderCallback("Hud callback", [fpsText, camera](Window& wnd) {
@@ -76,11 +114,14 @@ void Engine::mainCreate() {
         if (on_height_edit)
             info.sprintf("{} Height: {: .3f}m", info, human_height);
 
-        if (auto human = last_body.lock()) {
-            info.sprintf("{} Human speed: {: .2f}ms", info, human->velocity().magnitude());
+        human_info.update();
+        auto& human = human_info.read_buffer();
+
+        if (human.valid) {
+            info.sprintf("{} Human speed: {: .2f}ms", info, human.speed);
 
-            if (auto cast = human->ground_raycast_shin_left_info())
-                info.sprintf("{} Confirm: {: .2f}, {: .2f}m", info, cast->distance.x(), cast->distance.y());
+            if (human.ground)
+                info.sprintf("{} Confirm: {: .2f}, {: .2f}m", info, human.ground_x, human.ground_y);
         }
 
         fpsText->setString(info.data());
@@ -121,32 +162,38 @@ void Engine::mainCreate() {
             else if (evt.key.code == sf::Keyboard::E)
                 cam.rotate(5.f);
             else if (evt.key.code == sf::Keyboard::R) {
-                physic_simulation = PhysicSimulation::createTestSimulation();
-                physic_simulation->debug_draw(true);
-                physic_simulation->attachDrawableManager(drawable_manager);
-                physic_simulation->addPostUpdateCallback("clbk", physics_callback);
+                // The old thread is stopped first, callbacks of both threads must not run at once
+                physic_thread.reset();
+                physic_draw->clear();
+                physic_thread = createPhysicThread();
             }
             else if (evt.key.code == sf::Keyboard::H)
                 on_height_edit = true;
             else if (evt.key.code == sf::Keyboard::X) {
-                if (auto body = last_body.lock())
-                    body->makeMirror();
+                physic_thread->post([](PhysicSimulation& it) {
+                    if (auto body = last_body.lock())
+                        it.execute(SimulationCommand{SimulationCommand::Mirror, body->object_id()});
+                });
             }
             else if (evt.key.code == sf::Keyboard::LBracket) {
-                if (auto body = last_body.lock()) {
-                    for(size_t i = 0; i < PhysicHumanBody::BodyJoint_COUNT; ++i)
-                        body->freeze(PhysicHumanBody::BodyJoint(i));
-                }
+                physic_thread->post([](PhysicSimulation& it) {
+                    if (auto body = last_body.lock()) {
+                        for(uint32_t i = 0; i < PhysicHumanBody::BodyJoint_COUNT; ++i)
+                            it.execute(SimulationCommand{SimulationCommand::Freeze, body->object_id(), i});
+                    }
+                });
             }
         }
         else if (evt.type == sf::Event::KeyReleased) {
             if (evt.key.code == sf::Keyboard::H)
                 on_height_edit = false;
             else if (evt.key.code == sf::Keyboard::LBracket) {
-                if (auto body = last_body.lock()) {
-                    for(size_t i = 0; i < PhysicHumanBody::BodyJoint_COUNT; ++i)
-                        body->unfreeze(PhysicHumanBody::BodyJoint(i));
-                }
+                physic_thread->post([](PhysicSimulation& it) {
+                    if (auto body = last_body.lock()) {
+                        for(uint32_t i = 0; i < PhysicHumanBody::BodyJoint_COUNT; ++i)
+                            it.execute(SimulationCommand{SimulationCommand::Unfreeze, body->object_id(), i});
+                    }
+                });
             }
         }
         else if (evt.type == sf::Event::MouseWheelMoved) {
@@ -169,53 +216,38 @@ void Engine::mainCreate() {
             }
             else if (evt.mouseButton.button == sf::Mouse::Right) {
                 auto pos = wnd.getMouseCoords(cam);
-                last_body = physic_simulation->createHumanBody(pos, human_height, 80.f);
-                last_body.lock()->makeMirror();
-
-                auto& human = *last_body.lock();
-
-                auto pc = motion_interface::PeriodicCounter(last_body, "counter");
-                pc.set_period(0.5);
-
-                auto jp1n = motion_interface::AnimatedJoint(last_body, "animated_leg_r", PhysicHumanBody::BodyJoint_Chest_ThighR, "counter")
-                    .set_frames({{0.0, -0.3f}, {0.5, 0.6f}})
-                    .n_joint_processor();
-
-                auto jp2n = motion_interface::AnimatedJoint(last_body, "animated_leg_l", PhysicHumanBody::BodyJoint_Chest_ThighL, "counter")
-                    .set_frames({{0.0, -0.3}, {0.5, 0.6}})
-                    .set_shift(0.5)
-                    .n_joint_processor();
-
-                auto jp1 = human.joint_processor_cast_get<HolderJointProcessor>(jp1n);
-                auto jp2 = human.joint_processor_cast_get<HolderJointProcessor>(jp2n);
-                HolderJointProcessor::Pressets::human_leg_fast_tense(*jp1.lock());
-                HolderJointProcessor::Pressets::human_leg_fast_tense(*jp2.lock());
-
-                auto shin_l = human.joint_processor_new<HolderJointProcessor>("shin_l", PhysicHumanBody::BodyJoint_ThighL_ShinL);
-                auto shin_r = human.joint_processor_new<HolderJointProcessor>("shin_r", PhysicHumanBody::BodyJoint_ThighR_ShinR);
-                HolderJointProcessor::Pressets::human_shin_superweak(*shin_l.lock());
-                HolderJointProcessor::Pressets::human_shin_superweak(*shin_r.lock());
-
-                auto arm_l = human.joint_processor_new<HolderJointProcessor>("arm_l", PhysicHumanBody::BodyJoint_Chest_ArmL, 1.4f);
-                auto arm_r = human.joint_processor_new<HolderJointProcessor>("arm_r", PhysicHumanBody::BodyJoint_Chest_ArmR, 1.4f);
-                auto hand_l = human.joint_processor_new<HolderJointProcessor>("hand_l", PhysicHumanBody::BodyJoint_ArmL_HandL);
-                auto hand_r = human.joint_processor_new<HolderJointProcessor>("hand_r", PhysicHumanBody::BodyJoint_ArmR_HandR);
-
-                HolderJointProcessor::Pressets::human_hand_fast_tense(*arm_l.lock());
-                HolderJointProcessor::Pressets::human_hand_fast_tense(*arm_r.lock());
-                HolderJointProcessor::Pressets::human_hand_fast_tense(*hand_l.lock());
-                HolderJointProcessor::Pressets::human_hand_fast_tense(*hand_r.lock());
+                auto height = human_height;
+
+                physic_thread->post([pos, height](PhysicSimulation& it) {
+                    last_body = it.createHumanBody(pos, height, 80.f);
+
+                    auto id = last_body.lock()->object_id();
+                    it.execute(SimulationCommand{SimulationCommand::Mirror, id});
+
+                    auto setup = SimulationCommand{SimulationCommand::SetupHuman, id};
+                    setup.name = human_setups::WALKER;
+                    it.execute(setup);
+                });
             }
             else if (evt.mouseButton.button == sf::Mouse::Middle) {
-                if (auto human = last_body.lock()) {
-                    if (auto jp = human->joint_processor_cast_get<HolderJointProcessor>("hand_l").lock()) {
-                        auto hand_pos  = human->part_position(PhysicHumanBody::BodyPartHandL);
-                        auto joint_pos = human->joint_position(PhysicHumanBody::BodyJoint_ArmL_HandL);
-                        auto dir = (hand_pos - joint_pos).normalize();
-
-                        human->apply_impulse(PhysicHumanBody::BodyPartHandL, dir * -0.34, hand_pos + scl::Vector2f{-dir.y(), dir.x()} * 0.1f, true);
+                physic_thread->post([](PhysicSimulation& it) {
+                    if (auto human = last_body.lock()) {
+                        if (auto jp = human->joint_processor_cast_get<HolderJointProcessor>("hand_l").lock()) {
+                            auto hand_pos  = human->part_position(PhysicHumanBody::BodyPartHandL);
+                            auto joint_pos = human->joint_position(PhysicHumanBody::BodyJoint_ArmL_HandL);
+                            auto dir = (hand_pos - joint_pos).normalize();
+
+                            auto impulse = dir * -0.34f;
+                            auto point   = hand_pos + scl::Vector2f{-dir.y(), dir.x()} * 0.1f;
+
+                            auto command = SimulationCommand{SimulationCommand::ApplyImpulse, human->object_id(),
+                                                             PhysicHumanBody::BodyPartHandL};
+                            command.values = {impulse.x(), impulse.y(), point.x(), point.y()};
+                            command.flag   = true;
+                            it.execute(command);
+                        }
                     }
-                }
+                });
             }
         }
         else if (evt.type == sf::Event::MouseButtonReleased) {
@@ -224,16 +256,19 @@ void Engine::mainCreate() {
 
                 start_shoot = false;
                 auto vel = (wnd.getMouseCoords(cam) - start_pos) * 10;
-                physic_simulation->spawnBox(start_pos.x(), start_pos.y(), box_mass, vel);
+                physic_thread->post([pos = start_pos, mass = box_mass, vel](PhysicSimulation& it) {
+                    auto command = SimulationCommand{SimulationCommand::SpawnBox};
+                    command.values = {pos.x(), pos.y(), mass, vel.x(), vel.y()};
+                    it.execute(command);
+                });
             }
         }
     });
 
-    physic_simulation = PhysicSimulation::createTestSimulation();
-    physic_simulation->debug_draw(true);
-    physic_simulation->attachDrawableManager(drawable_manager);
-    physic_simulation->addPostUpdateCallback("clbk", physics_callback);
-    //physic_simulation->gravity(0, 0);
+    physic_draw   = SfmlPhysicThreadDraw::createUnique(drawable_manager);
+    physic_draw->attachCamera(camera);
+    physic_thread = createPhysicThread();
+    //physic_thread->post([](PhysicSimulation& it) { it.gravity(0, 0); });
 
     wnd->addUiCallback("Physics Ui", uiPhysics(drawable_manager));
 }
@@ -2,6 +2,9 @@
 
 #include "src/machine_learning/NeuralNetwork.hpp"
 #include "src/machine_learning/MnistDataset.hpp"
+#include "src/machine_learning/DataLoader.hpp"
+#include "src/machine_learning/Augmentation.hpp"
+#include "src/machine_learning/Evaluation.hpp"
 #include "src/utils/ReaderWriter.hpp"
 
 auto createNetwork() {
@@ -39,9 +42,6 @@ auto readOrCreateNetwork() {
 int main() {
     auto [trainset, testset] = nnw::MnistDataset::remote_load();
 
-    auto uid_gen_train = std::bind(nnw::helper::uniform_dist<size_t>, 0, trainset.count() - 1);
-    auto uid_gen_test  = std::bind(nnw::helper::uniform_dist<size_t>, 0, testset. count() - 1);
-
     size_t stage1_iters = 40000;
     size_t stage2_iters = 120000;
 
@@ -70,43 +70,55 @@ int main() {
     };
 
     if (need_training) {
-        for (size_t i = 0; i < stage1_iters; ++i) {
-            auto rand_idx = uid_gen_train();
-            auto output = network.forward_pass(trainset.data()[rand_idx].data());
+        auto& image   = trainset.data().front();
+        auto  workers = std::max(std::thread::hardware_concurrency() / 2, 1U);
+
+        auto augmentation = nnw::Augmentation(image.width(), image.height(), nnw::AugmentationParams(), workers);
+        auto loader       = nnw::DataLoader(trainset, 50, 8, workers, 0, augmentation.transform());
+        auto batch  = nnw::Batch();
+
+        while (all < stage1_iters && loader.next(batch)) {
+            for (size_t i = 0; i < batch.size && all < stage1_iters; ++i) {
+                auto output = network.forward_pass(batch.sample(i));
 
-            auto real_answer = trainset.labels()[rand_idx];
-            fmt::print("\rStage 1, stochastic gradient descend, Iteration: {}/{} Accuracy: {:3.2f}%",
-                       all, stage1_iters, get_accuracy(output, real_answer));
-            std::flush(std::cout);
+                auto real_answer = batch.label(i);
+                fmt::print("\rStage 1, stochastic gradient descend, Iteration: {}/{} Accuracy: {:3.2f}%",
+                           all, stage1_iters, get_accuracy(output, real_answer));
+                std::flush(std::cout);
 
-            network.backpropagate_sgd(generate_ideal(real_answer));
+                network.backpropagate_sgd(generate_ideal(real_answer));
+            }
         }
         std::cout << std::endl;
-        network.update_batch_size(50);
+        network.update_batch_size(loader.batch_size());
 
-        for (size_t i = 0; i < stage2_iters; ++i) {
-            auto rand_idx = uid_gen_train();
-            auto output = network.forward_pass(trainset.data()[rand_idx].data());
+        while (all - stage1_iters < stage2_iters && loader.next(batch)) {
+            for (size_t i = 0; i < batch.size && all - stage1_iters < stage2_iters; ++i) {
+                auto output = network.forward_pass(batch.sample(i));
 
-            auto real_answer = trainset.labels()[rand_idx];
-            fmt::print("\rStage 2, batch gradient descend, Iteration: {}/{} Accuracy: {:3.2f}%",
-                       all - stage1_iters, stage2_iters, get_accuracy(output, real_answer));
-            std::flush(std::cout);
+                auto real_answer = batch.label(i);
+                fmt::print("\rStage 2, batch gradient descend, Iteration: {}/{} Accuracy: {:3.2f}%",
+                           all - stage1_iters, stage2_iters, get_accuracy(output, real_answer));
+                std::flush(std::cout);
 
-            network.backpropagate_bgd(generate_ideal(real_answer));
+                network.backpropagate_bgd(generate_ideal(real_answer));
+            }
         }
     }
 
-    all = hits = 0;
-    float accuracy = 0;
-    for (size_t i = 0; i < testset.count(); ++i) {
-        auto output = network.forward_pass(testset.data()[i].data());
-        accuracy = get_accuracy(output, testset.labels()[i]);
-        fmt::print("\rTest stage, Iteration: {}/{}", all, testset.count());
+    auto result = nnw::evaluate(network, testset, 0, [](size_t done, size_t total) {
+        fmt::print("\rTest stage, Iteration: {}/{}", done, total);
         std::flush(std::cout);
-    }
+    });
+
+    fmt::print("\nDone, result accuracy: {:3.2f}% ({:.0f} samples/sec)\n", result.accuracy, result.samples_per_sec);
 
-    fmt::print("\nDone, result accuracy: {:3.2f}%\n", accuracy);
+    fmt::print("Confusion matrix (row - real, column - answer):\n");
+    for (size_t real = 0; real < result.classes; ++real) {
+        for (size_t answer = 0; answer < result.classes; ++answer)
+            fmt::print("{:6}", result.confusion_at(real, answer));
+        fmt::print("\n");
+    }
 
     network.save("mnist.nnw");
 
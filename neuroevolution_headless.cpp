@@ -0,0 +1,262 @@
+#include <atomic>
+#include <fstream>
+#include <fmt/format.h>
+
+#include "src/core/time.hpp"
+#include "src/core/ThreadPool.hpp"
+#include "src/core/Philox.hpp"
+#include "src/game/PhysicSimulation.hpp"
+#include "src/game/PhysicHumanBody.hpp"
+#include "src/machine_learning/NeuralNetwork.hpp"
+#include "src/machine_learning/Genetic.hpp"
+#include "src/machine_learning/WeightOperators.hpp"
+
+/*
+ * Headless neuroevolution of walking controllers
+ *
+ * Every individual is a flat vector of controller network weights. Fitness of the individual is
+ * computed on its own PhysicSimulation, stepped with fixed step() calls as fast as possible.
+ * Individuals are evaluated in parallel, every pool worker owns a copy of the controller network.
+ * Box2D updates global profiling counters (b2_gjkCalls, b2_toiCalls, ...) in every step without
+ * synchronization, so parallel episodes race on them (ThreadSanitizer reports it). Only these
+ * statistics are affected, episodes stay deterministic.
+ *
+ * The population is checkpointed in background every [checkpoint interval] generations,
+ * an existing checkpoint is resumed on start and the run continues from its generation.
+ *
+ * Runs with the same seed are bit-reproducible regardless of the threads count: episodes are deterministic
+ * and all random numbers are taken from Philox streams of the seed on the breeding thread. Operator streams
+ * are derived from the generation number and the seed is restored from the checkpoint, so a resumed run
+ * continues exactly as the uninterrupted one.
+ *
+ * Usage: neuroevolution_headless [population] [generations] [threads] [episode seconds] [checkpoint interval] [seed]
+ */
+
+using Genome = std::vector<float>;
+
+static constexpr size_t JOINTS_COUNT = PhysicHumanBody::BodyJoint_COUNT;
+static constexpr size_t INPUTS_COUNT = JOINTS_COUNT * 2 + 5;
+static constexpr float  MAX_SPEED    = 6.f;
+static constexpr float  MAX_TORQUE   = 4.f;
+static constexpr float  FALL_HEIGHT  = 0.6f; // Episode ends when chest is lower
+static constexpr auto   CHECKPOINT   = "neuroevolution_checkpoint.bin";
+
+auto createController() {
+    auto builder = nnw::NeuralNetwork("Walk controller");
+    auto input   = builder.new_neuron_group(INPUTS_COUNT, nnw::activations::Identity());
+    auto hidden  = builder.new_neuron_group(32, nnw::activations::Tanh());
+    auto output  = builder.new_neuron_group(JOINTS_COUNT, nnw::activations::Tanh());
+    auto biases  = builder.new_neuron_group(2, nnw::NeuronType::Bias);
+
+    builder.allover_connect(input, hidden);
+    builder.allover_connect(hidden, output);
+
+    builder.allover_connect(biases[0], hidden);
+    builder.allover_connect(biases[1], output);
+
+    builder.init_weights(nnw::InitializerStrategy::Xavier);
+
+    return builder.compile();
+}
+
+void load_genome(nnw::FeedForwardNeuralNetwork& network, const Genome& genome) {
+    network.import_weights(genome.data());
+}
+
+// Per-worker evaluation context
+struct Worker {
+    nnw::FeedForwardNeuralNetwork network;
+    scl::Vector<float>            input = scl::Vector<float>(INPUTS_COUNT, 0.f);
+};
+
+// Summary time of all workers in phases of evaluation
+struct PhaseTimes {
+    std::atomic<int64_t> physics_ns    = 0;
+    std::atomic<int64_t> controller_ns = 0;
+    std::atomic<size_t>  steps         = 0;
+};
+
+float episode(Worker& worker, const Genome& genome, size_t max_steps, PhaseTimes& times) {
+    load_genome(worker.network, genome);
+
+    auto simulation = PhysicSimulation::createTestSimulation();
+    auto body       = simulation->createHumanBody({0.f, 0.f}).lock();
+    auto start_x    = body->center_of_mass().x();
+
+    int64_t physics_ns    = 0;
+    int64_t controller_ns = 0;
+    size_t  step          = 0;
+
+    for (; step < max_steps; ++step) {
+        auto t0 = timer().timestamp();
+
+        auto& in = worker.input;
+        for (size_t j = 0; j < JOINTS_COUNT; ++j) {
+            auto joint = PhysicHumanBody::BodyJoint(j);
+            in[j]                = body->joint_angle(joint);
+            in[JOINTS_COUNT + j] = body->joint_speed(joint) / MAX_SPEED;
+        }
+
+        auto velocity = body->velocity();
+        in[JOINTS_COUNT * 2 + 0] = body->part_angle();
+        in[JOINTS_COUNT * 2 + 1] = body->angular_speed();
+        in[JOINTS_COUNT * 2 + 2] = velocity.x();
+        in[JOINTS_COUNT * 2 + 3] = velocity.y();
+        in[JOINTS_COUNT * 2 + 4] = body->part_position(PhysicHumanBody::BodyPartChest).y();
+
+        auto output = worker.network.forward_pass<false>(in.data());
+
+        for (size_t j = 0; j < JOINTS_COUNT; ++j)
+            body->enableMotor(PhysicHumanBody::BodyJoint(j), output[j] * MAX_SPEED, MAX_TORQUE);
+
+        auto t1 = timer().timestamp();
+        simulation->step();
+        auto t2 = timer().timestamp();
+
+        controller_ns += (t1 - t0).nano();
+        physics_ns    += (t2 - t1).nano();
+
+        if (body->part_position(PhysicHumanBody::BodyPartChest).y() < FALL_HEIGHT)
+            break;
+    }
+
+    times.physics_ns    += physics_ns;
+    times.controller_ns += controller_ns;
+    times.steps         += step;
+
+    // Walked distance with a small reward for staying on feet
+    auto distance = body->center_of_mass().x() - start_x;
+    return distance + 0.5f * float(step) / float(max_steps);
+}
+
+int main(int argc, char* argv[]) {
+    size_t population  = argc > 1 ? std::stoul(argv[1]) : 200;
+    size_t generations = argc > 2 ? std::stoul(argv[2]) : 100;
+    size_t threads     = argc > 3 ? std::stoul(argv[3]) : 0;
+    double seconds     = argc > 4 ? std::stod (argv[4]) : 10.0;
+    size_t checkpoints = argc > 5 ? std::stoul(argv[5]) : 10;
+    auto   seed        = argc > 6 ? std::stoull(argv[6]) : uint64_t(std::random_device()());
+
+    auto controller   = createController();
+    auto weights_size = controller.weights_count();
+
+    auto pool      = ThreadPool(threads);
+    auto step_time = PhysicSimulation().step_time();
+    auto max_steps = static_cast<size_t>(seconds / step_time);
+
+    std::vector<Worker> workers;
+    workers.reserve(pool.size());
+    for (size_t i = 0; i < pool.size(); ++i)
+        workers.push_back(Worker{controller});
+
+    // Stream 0 is used by the selection of Genetic
+    auto genetic = Genetic<Genome>(population, seed);
+
+    if (std::ifstream(CHECKPOINT).good()) {
+        genetic.load_checkpoint(CHECKPOINT);
+        fmt::print("Resumed from '{}' at generation {}\n", CHECKPOINT, genetic.generation());
+
+        if (genetic.generation_size() != population || genetic.at(0).get().size() != weights_size)
+            throw std::runtime_error("Checkpoint doesn't match population size or controller");
+
+        if (argc > 6 && genetic.rand_gen().seed() != seed)
+            fmt::print("Seed {} is ignored, the checkpoint continues with its own seed\n", seed);
+
+        seed = genetic.rand_gen().seed();
+    }
+    else {
+        // Stream 2 is used by the initial population only
+        auto rand_gen = Philox4x32(seed, 2);
+
+        genetic.init([&] {
+            auto genome = Genome(weights_size);
+            nnw::weight_ops::gaussian_noise(genome.data(), weights_size, seed, rand_gen.next_u64());
+
+            auto scale = 1.f / std::sqrt(float(INPUTS_COUNT));
+            for (auto& w : genome)
+                w *= scale;
+
+            return genome;
+        });
+    }
+
+    fmt::print("Population: {}, weights: {}, threads: {}, episode: {}s ({} steps), seed: {}\n",
+               population, weights_size, pool.size(), seconds, max_steps, seed);
+
+    genetic.enable_async_checkpoints(CHECKPOINT, checkpoints);
+
+    // Every operator call takes its own Philox stream. Breeding of every generation starts from
+    // the stream of its number, so operators of a resumed run get the same streams
+    auto operator_streams = Philox4x32(seed, 1);
+    auto rand_gen         = operator_streams;
+
+    genetic.set_crossing_over_inplace_callback([&](Chromosome<Genome>& a, Chromosome<Genome>& b, Genome& child) {
+        child.resize(a.get().size());
+        nnw::weight_ops::crossover_uniform(a.get().data(), b.get().data(), child.data(), child.size(),
+                                           seed, rand_gen.next_u64());
+    });
+
+    genetic.set_mutation_callback([&](Chromosome<Genome>& chromosome, float intensity) {
+        auto& genome = chromosome.get();
+        nnw::weight_ops::perturb_gaussian(genome.data(), genome.size(), intensity, seed, rand_gen.next_u64());
+    });
+
+    genetic.mutation_intensity_factor(0.1f);
+
+    auto report = GenerationReport();
+    genetic.set_report_callback([&](const GenerationReport& r) { report = r; });
+
+    auto best_genome  = Genome();
+    auto best_fitness = -std::numeric_limits<float>::infinity();
+    auto total_timer  = Timer();
+    auto total_time   = 0.0;
+
+    auto first_gen = genetic.generation();
+
+    for (auto gen = first_gen; gen < generations; ++gen) {
+        auto times = PhaseTimes();
+        auto phase = Timer();
+
+        genetic.evaluate([&](Genome& genome, Worker& worker) {
+            return episode(worker, genome, max_steps, times);
+        }, workers, pool);
+
+        auto evaluate_time = phase.tick().sec();
+
+        phase.tick();
+        rand_gen = operator_streams.split(genetic.generation());
+        genetic.perform_new_generation();
+        auto breed_time = phase.tick().sec();
+
+        if (report.best_fitness > best_fitness) {
+            auto& last     = genetic.last_generation();
+            auto  gen_best = std::max_element(last.begin(), last.end(), [](auto& lhs, auto& rhs) {
+                return lhs.fitness_factor() < rhs.fitness_factor();
+            });
+
+            best_fitness = report.best_fitness;
+            best_genome  = gen_best->get();
+        }
+
+        total_time += total_timer.tick().sec();
+
+        auto steps = std::max<size_t>(times.steps, 1);
+
+        fmt::print("Generation {:4}  best: {:8.3f}  mean: {:8.3f}  median: {:8.3f}  best ever: {:8.3f}  "
+                   "gen/hour: {:8.1f}  evaluate: {:.3f}s  breed: {:.3f}s  physics: {:.2f}us/step  "
+                   "controller: {:.2f}us/step  steps/sec: {:.0f}  mutations: {}{}\n",
+                   report.generation, report.best_fitness, report.mean_fitness, report.median_fitness, best_fitness,
+                   3600.0 * (gen + 1 - first_gen) / total_time, evaluate_time, breed_time,
+                   times.physics_ns / 1000.0 / steps, times.controller_ns / 1000.0 / steps,
+                   times.steps / evaluate_time, report.mutation_count, report.supermutation ? " (supermutation)" : "");
+    }
+
+    genetic.flush_checkpoints();
+
+    if (!best_genome.empty()) {
+        load_genome(controller, best_genome);
+        controller.save("neuroevolution_best.nnw");
+    }
+
+    return 0;
+}
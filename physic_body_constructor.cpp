@@ -12,8 +12,11 @@ void Engine::mainCreate() {
     camera->attachDrawableManager(drawable_manager);
     window->addCamera(camera);
 
-    physic_simulation = PhysicSimulation::createUnique();
-    physic_simulation->gravity(0, 0);
+    physic_draw = SfmlPhysicThreadDraw::createUnique(drawable_manager);
+    physic_draw->attachCamera(camera);
+
+    physic_thread = std::make_unique<PhysicThread>(PhysicSimulation::createUnique());
+    physic_thread->post([](PhysicSimulation& it) { it.gravity(0, 0); });
 
     window->addUiCallback("Ui callback", uiPhysics(drawable_manager));
 
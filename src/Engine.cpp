@@ -41,8 +41,9 @@ void Engine::onUpdate() {
                     wnd.first->eventUpdate();
 
             // Do other stuff
-            if (physic_simulation) {
-                physic_simulation->update();
+            // Physics runs on its own thread, only its latest state is taken here
+            if (physic_thread && physic_draw) {
+                physic_draw->sync(*physic_thread);
             }
 
             for (auto& wnd : wnds)
@@ -5,11 +5,12 @@
 #include "core/helper_macros.hpp"
 #include "graphics/Window.hpp"
 #include "graphics/ObjectManager.hpp"
-#include "game/PhysicSimulation.hpp"
+#include "game/PhysicThread.hpp"
+#include "graphics/SfmlPhysicThreadDraw.hpp"
 #include "graphics/FontManager.hpp"
 
 class Window;
-class PhysicSimulation;
+class PhysicThread;
 
 
 struct WindowParams {
@@ -46,6 +47,7 @@ private:
 
 private:
     ska::flat_hash_map<std::shared_ptr<Window>, WindowParams> _windows;
-    std::unique_ptr<PhysicSimulation> physic_simulation;
+    std::unique_ptr<PhysicThread>     physic_thread;
+    SfmlPhysicThreadDraw::UniquePtr   physic_draw;
     FontManager _font_manager;
 };
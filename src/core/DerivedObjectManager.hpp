@@ -65,6 +65,10 @@ public:
         return _data;
     }
 
+    auto& data() const {
+        return _data;
+    }
+
 protected:
     ska::flat_hash_set<std::shared_ptr<BaseType>> _data;
 };
\ No newline at end of file
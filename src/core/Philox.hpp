@@ -0,0 +1,218 @@
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <limits>
+#include <istream>
+#include <ostream>
+
+
+/**
+ * Philox4x32-10 counter-based random generator (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+ *
+ * Every block of four numbers is a pure function of (seed, stream, position), there is no hidden state
+ * except the position. So any count of independent streams may be created from one seed without
+ * synchronization (one per thread, per individual, per sample) and the result doesn't depend on the order
+ * in which threads run. Satisfies UniformRandomBitGenerator, so std distributions and std::shuffle work with it.
+ */
+class Philox4x32 {
+public:
+    using result_type = uint32_t;
+
+    /**
+     * @param seed - key of the generator
+     * @param stream - index of the stream, different streams of the same seed are independent
+     */
+    explicit Philox4x32(uint64_t seed = 0, uint64_t stream = 0): _seed(seed), _stream(stream) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        if (_index == 4) {
+            _block = generate(_seed, _stream, _position++);
+            _index = 0;
+        }
+
+        return _block[_index++];
+    }
+
+    uint64_t next_u64() {
+        auto lo = uint64_t((*this)());
+        auto hi = uint64_t((*this)());
+        return (hi << 32U) | lo;
+    }
+
+    /**
+     * @return uniform float in [0, 1) with 24 random bits
+     */
+    float next_float() {
+        return float((*this)() >> 8U) * (1.f / 16777216.f);
+    }
+
+    /**
+     * Child stream for the id, e.g. rng.split(generation).split(individual)
+     * Children with different ids don't overlap with each other and with the parent
+     */
+    Philox4x32 split(uint64_t id) const {
+        return Philox4x32(_seed, mix(_stream, id));
+    }
+
+    void discard(uint64_t count) {
+        auto offset = consumed() + count;
+
+        _position = offset / 4;
+        _index    = 4;
+
+        if (offset % 4 != 0) {
+            _block = generate(_seed, _stream, _position++);
+            _index = static_cast<uint32_t>(offset % 4);
+        }
+    }
+
+    /**
+     * @return count of 32-bit numbers generated from the start of the stream
+     */
+    uint64_t consumed() const {
+        return _position * 4 - (4 - _index);
+    }
+
+    uint64_t seed()   const { return _seed; }
+    uint64_t stream() const { return _stream; }
+
+    bool operator==(const Philox4x32& rhs) const {
+        return _seed == rhs._seed && _stream == rhs._stream && consumed() == rhs.consumed();
+    }
+
+    bool operator!=(const Philox4x32& rhs) const {
+        return !(*this == rhs);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Philox4x32& rng) {
+        return os << rng._seed << ' ' << rng._stream << ' ' << rng.consumed();
+    }
+
+    friend std::istream& operator>>(std::istream& is, Philox4x32& rng) {
+        uint64_t seed, stream, consumed;
+
+        if (is >> seed >> stream >> consumed) {
+            rng = Philox4x32(seed, stream);
+            rng.discard(consumed);
+        }
+
+        return is;
+    }
+
+    /**
+     * Philox4x32-10 block function
+     * @param key - 64-bit key
+     * @param stream - high half of the counter
+     * @param position - low half of the counter
+     */
+    static std::array<uint32_t, 4> generate(uint64_t key, uint64_t stream, uint64_t position) {
+        uint32_t c0 = uint32_t(position), c1 = uint32_t(position >> 32U);
+        uint32_t c2 = uint32_t(stream),   c3 = uint32_t(stream   >> 32U);
+        uint32_t k0 = uint32_t(key),      k1 = uint32_t(key      >> 32U);
+
+        for (int round = 0; round < 10; ++round) {
+            if (round != 0) {
+                k0 += 0x9E3779B9;
+                k1 += 0xBB67AE85;
+            }
+
+            auto p0 = uint64_t(0xD2511F53) * c0;
+            auto p1 = uint64_t(0xCD9E8D57) * c2;
+
+            c0 = uint32_t(p1 >> 32U) ^ c1 ^ k0;
+            c1 = uint32_t(p1);
+            c2 = uint32_t(p0 >> 32U) ^ c3 ^ k1;
+            c3 = uint32_t(p0);
+        }
+
+        return {c0, c1, c2, c3};
+    }
+
+    /**
+     * Generate blocks [position, position + blocks) of the stream, 4 * blocks numbers
+     * Lanes of LANES blocks are computed together (structure of arrays), so the rounds are vectorized
+     *
+     * @param key - 64-bit key
+     * @param stream - high half of the counter
+     * @param position - index of the first block
+     * @param out - destination, numbers are stored in the same order as operator() returns them
+     * @param blocks - count of blocks
+     */
+    static void generate(uint64_t key, uint64_t stream, uint64_t position, uint32_t* out, size_t blocks) {
+        constexpr size_t LANES = 8;
+
+        size_t b = 0;
+
+        for (; b + LANES <= blocks; b += LANES) {
+            uint32_t c0[LANES], c1[LANES], c2[LANES], c3[LANES];
+
+            for (size_t l = 0; l < LANES; ++l) {
+                auto counter = position + b + l;
+                c0[l] = uint32_t(counter);
+                c1[l] = uint32_t(counter >> 32U);
+                c2[l] = uint32_t(stream);
+                c3[l] = uint32_t(stream >> 32U);
+            }
+
+            uint32_t k0 = uint32_t(key), k1 = uint32_t(key >> 32U);
+
+            for (int round = 0; round < 10; ++round) {
+                if (round != 0) {
+                    k0 += 0x9E3779B9;
+                    k1 += 0xBB67AE85;
+                }
+
+                for (size_t l = 0; l < LANES; ++l) {
+                    auto p0 = uint64_t(0xD2511F53) * c0[l];
+                    auto p1 = uint64_t(0xCD9E8D57) * c2[l];
+
+                    c0[l] = uint32_t(p1 >> 32U) ^ c1[l] ^ k0;
+                    c1[l] = uint32_t(p1);
+                    c2[l] = uint32_t(p0 >> 32U) ^ c3[l] ^ k1;
+                    c3[l] = uint32_t(p0);
+                }
+            }
+
+            for (size_t l = 0; l < LANES; ++l) {
+                out[(b + l) * 4 + 0] = c0[l];
+                out[(b + l) * 4 + 1] = c1[l];
+                out[(b + l) * 4 + 2] = c2[l];
+                out[(b + l) * 4 + 3] = c3[l];
+            }
+        }
+
+        for (out += b * 4; b < blocks; ++b, out += 4) {
+            auto block = generate(key, stream, position + b);
+            out[0] = block[0];
+            out[1] = block[1];
+            out[2] = block[2];
+            out[3] = block[3];
+        }
+    }
+
+    /**
+     * Hash of two 64-bit values (splitmix64 finalizer), used to derive stream ids and sample keys
+     */
+    static uint64_t mix(uint64_t a, uint64_t b) {
+        auto finalize = [](uint64_t x) {
+            x += 0x9E3779B97F4A7C15ULL;
+            x  = (x ^ (x >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+            x  = (x ^ (x >> 27U)) * 0x94D049BB133111EBULL;
+            return x ^ (x >> 31U);
+        };
+
+        return finalize(a ^ finalize(b));
+    }
+
+private:
+    uint64_t _seed;
+    uint64_t _stream;
+    uint64_t _position = 0;
+
+    std::array<uint32_t, 4> _block = {};
+    uint32_t                _index = 4;
+};
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread
+ *
+ * Ring buffer with monotonic head/tail counters. Each side keeps a cached copy of the other side's
+ * counter, so the shared cache line is touched only when the queue looks full (producer) or empty (consumer).
+ * Slots are preallocated, T must be default constructible and move assignable.
+ */
+template <typename T>
+class SpscQueue {
+public:
+    /**
+     * @param capacity - minimal capacity, rounded up to the power of two
+     */
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+
+        _buffer.resize(size);
+        _mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * Producer side
+     * @return false if the queue is full, value is not moved in this case
+     */
+    bool try_push(T&& value) {
+        auto tail = _tail.load(std::memory_order_relaxed);
+
+        if (tail - _head_cache == _buffer.size()) {
+            _head_cache = _head.load(std::memory_order_acquire);
+            if (tail - _head_cache == _buffer.size())
+                return false;
+        }
+
+        _buffer[tail & _mask] = std::move(value);
+        _tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    bool try_push(const T& value) {
+        auto copy = value;
+        return try_push(std::move(copy));
+    }
+
+    /**
+     * Consumer side
+     * @return false if the queue is empty
+     */
+    bool try_pop(T& value) {
+        auto head = _head.load(std::memory_order_relaxed);
+
+        if (head == _tail_cache) {
+            _tail_cache = _tail.load(std::memory_order_acquire);
+            if (head == _tail_cache)
+                return false;
+        }
+
+        value = std::move(_buffer[head & _mask]);
+        _head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /**
+     * Approximate count of elements, exact only when called from the producer or the consumer
+     * while the other side is idle
+     */
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    size_t capacity() const {
+        return _buffer.size();
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::vector<T> _buffer;
+    size_t         _mask = 0;
+
+    // Consumer side
+    alignas(CACHE_LINE) std::atomic<size_t> _head = 0;
+    size_t                                  _tail_cache = 0;
+
+    // Producer side
+    alignas(CACHE_LINE) std::atomic<size_t> _tail = 0;
+    size_t                                  _head_cache = 0;
+};
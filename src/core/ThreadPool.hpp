@@ -0,0 +1,141 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+#include <vector>
+
+
+/**
+ * Fixed set of worker threads for data-parallel loops
+ *
+ * Workers are created once and sleep between jobs, so parallel_for() may be called every frame or
+ * every generation without thread creation cost. Every worker has stable index in [0, size()),
+ * which can be used to select per-worker context (scratch buffers, private physics world, etc).
+ */
+class ThreadPool {
+public:
+    using JobT = std::function<void(size_t /* index */, size_t /* worker */)>;
+
+    /**
+     * @param threads - count of workers (0 - hardware concurrency)
+     */
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0)
+            threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+        for (size_t i = 0; i < threads; ++i)
+            _workers.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            auto lock = std::lock_guard(_mutex);
+            _stop = true;
+        }
+
+        _job_cv.notify_all();
+
+        for (auto& worker : _workers)
+            worker.join();
+    }
+
+    /**
+     * Call job(index, worker) for every index in [0, count) and wait for completion
+     * Indices are taken by workers dynamically, so jobs of different duration are balanced.
+     * First exception thrown by a job is rethrown in the calling thread, remaining indices are skipped.
+     * Must not be called concurrently or from the job itself.
+     *
+     * @param count - count of indices
+     * @param job - job function
+     */
+    void parallel_for(size_t count, const JobT& job) {
+        if (count == 0)
+            return;
+
+        {
+            auto lock = std::lock_guard(_mutex);
+            _job     = &job;
+            _count   = count;
+            _error   = nullptr;
+            _active  = _workers.size();
+            _next.store(0, std::memory_order_relaxed);
+            ++_job_id;
+        }
+
+        _job_cv.notify_all();
+
+        auto lock = std::unique_lock(_mutex);
+        _done_cv.wait(lock, [this] { return _active == 0; });
+
+        _job = nullptr;
+
+        if (_error)
+            std::rethrow_exception(_error);
+    }
+
+    size_t size() const {
+        return _workers.size();
+    }
+
+private:
+    void worker_loop(size_t worker) {
+        size_t last_job_id = 0;
+
+        while (true) {
+            const JobT* job;
+            size_t      count;
+
+            {
+                auto lock = std::unique_lock(_mutex);
+                _job_cv.wait(lock, [&] { return _stop || _job_id != last_job_id; });
+
+                if (_stop)
+                    return;
+
+                last_job_id = _job_id;
+                job         = _job;
+                count       = _count;
+            }
+
+            try {
+                for (size_t i = _next.fetch_add(1); i < count; i = _next.fetch_add(1))
+                    (*job)(i, worker);
+            }
+            catch (...) {
+                auto lock = std::lock_guard(_mutex);
+                if (!_error)
+                    _error = std::current_exception();
+
+                _next.store(count);
+            }
+
+            {
+                auto lock = std::lock_guard(_mutex);
+                if (--_active == 0)
+                    _done_cv.notify_one();
+            }
+        }
+    }
+
+private:
+    std::vector<std::thread> _workers;
+
+    std::mutex              _mutex;
+    std::condition_variable _job_cv;
+    std::condition_variable _done_cv;
+
+    const JobT*         _job    = nullptr;
+    size_t              _count  = 0;
+    size_t              _active = 0;
+    size_t              _job_id = 0;
+    std::atomic<size_t> _next   = 0;
+    std::exception_ptr  _error;
+    bool                _stop   = false;
+};
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * Lock-free triple buffer for exactly one writer thread and one reader thread
+ *
+ * The writer fills write_buffer() and publishes it, the reader takes the latest published buffer with update().
+ * Neither side ever waits: intermediate values are dropped if the writer is faster than the reader.
+ * Buffers are reused, so the writer gets back an old value (e.g. vectors keep their capacity).
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    /**
+     * Writer side
+     */
+    T& write_buffer() {
+        return _buffers[_write];
+    }
+
+    /**
+     * Writer side: make write_buffer() the latest value and take a free buffer for the next write
+     */
+    void publish() {
+        auto middle = _middle.exchange(uint8_t(_write | FRESH), std::memory_order_acq_rel);
+        _write = middle & INDEX;
+    }
+
+    /**
+     * Reader side: take the latest published value
+     * @return false if nothing was published since the last update()
+     */
+    bool update() {
+        if (!(_middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+
+        auto middle = _middle.exchange(_read, std::memory_order_acq_rel);
+        _read = middle & INDEX;
+
+        return true;
+    }
+
+    /**
+     * Reader side: value taken by the last successful update()
+     */
+    const T& read_buffer() const {
+        return _buffers[_read];
+    }
+
+private:
+    static constexpr size_t  CACHE_LINE = 64;
+    static constexpr uint8_t INDEX      = 0b011;
+    static constexpr uint8_t FRESH      = 0b100;
+
+    std::array<T, 3> _buffers;
+
+    // Index of the middle buffer and a flag of unread value
+    alignas(CACHE_LINE) std::atomic<uint8_t> _middle = 1;
+
+    alignas(CACHE_LINE) uint8_t _write = 0;
+    alignas(CACHE_LINE) uint8_t _read  = 2;
+};
@@ -15,7 +15,8 @@ HolderJointProcessor::HolderJointProcessor(b2Joint* j, float hold_angle) {
 }
 
 HolderJointProcessor::~HolderJointProcessor() {
-    _joint->EnableMotor(false);
+    if (!_detached)
+        _joint->EnableMotor(false);
 }
 
 void HolderJointProcessor::update(const PhysicBodyBase&, double time_step)  {
@@ -23,6 +23,10 @@ public:
     {}
 
     ~HolderJointProcessor() final;
+
+    JointProcessor::SharedPtr clone() const final {
+        return clone_as<HolderJointProcessor>();
+    }
     void update(const class PhysicBodyBase&, double time_step) final;
 
 private:
@@ -0,0 +1,45 @@
+#include "HumanSetups.hpp"
+
+#include "PhysicHumanBody.hpp"
+#include "HolderJointProcessor.hpp"
+#include "MotionInterfaces.hpp"
+
+void human_setups::walker(const PhysicSimulation::PhysicHumanBodyWP& body) {
+    auto& human = *body.lock();
+
+    auto pc = motion_interface::PeriodicCounter(body, "counter");
+    pc.set_period(0.5);
+
+    auto jp1n = motion_interface::AnimatedJoint(body, "animated_leg_r", PhysicHumanBody::BodyJoint_Chest_ThighR, "counter")
+        .set_frames({{0.0, -0.3f}, {0.5, 0.6f}})
+        .n_joint_processor();
+
+    auto jp2n = motion_interface::AnimatedJoint(body, "animated_leg_l", PhysicHumanBody::BodyJoint_Chest_ThighL, "counter")
+        .set_frames({{0.0, -0.3}, {0.5, 0.6}})
+        .set_shift(0.5)
+        .n_joint_processor();
+
+    auto jp1 = human.joint_processor_cast_get<HolderJointProcessor>(jp1n);
+    auto jp2 = human.joint_processor_cast_get<HolderJointProcessor>(jp2n);
+    HolderJointProcessor::Pressets::human_leg_fast_tense(*jp1.lock());
+    HolderJointProcessor::Pressets::human_leg_fast_tense(*jp2.lock());
+
+    auto shin_l = human.joint_processor_new<HolderJointProcessor>("shin_l", PhysicHumanBody::BodyJoint_ThighL_ShinL);
+    auto shin_r = human.joint_processor_new<HolderJointProcessor>("shin_r", PhysicHumanBody::BodyJoint_ThighR_ShinR);
+    HolderJointProcessor::Pressets::human_shin_superweak(*shin_l.lock());
+    HolderJointProcessor::Pressets::human_shin_superweak(*shin_r.lock());
+
+    auto arm_l = human.joint_processor_new<HolderJointProcessor>("arm_l", PhysicHumanBody::BodyJoint_Chest_ArmL, 1.4f);
+    auto arm_r = human.joint_processor_new<HolderJointProcessor>("arm_r", PhysicHumanBody::BodyJoint_Chest_ArmR, 1.4f);
+    auto hand_l = human.joint_processor_new<HolderJointProcessor>("hand_l", PhysicHumanBody::BodyJoint_ArmL_HandL);
+    auto hand_r = human.joint_processor_new<HolderJointProcessor>("hand_r", PhysicHumanBody::BodyJoint_ArmR_HandR);
+
+    HolderJointProcessor::Pressets::human_hand_fast_tense(*arm_l.lock());
+    HolderJointProcessor::Pressets::human_hand_fast_tense(*arm_r.lock());
+    HolderJointProcessor::Pressets::human_hand_fast_tense(*hand_l.lock());
+    HolderJointProcessor::Pressets::human_hand_fast_tense(*hand_r.lock());
+}
+
+void human_setups::add_all(PhysicSimulation& simulation) {
+    simulation.addHumanSetup(WALKER, walker);
+}
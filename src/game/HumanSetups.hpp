@@ -0,0 +1,23 @@
+#pragma once
+
+#include "PhysicSimulation.hpp"
+
+/**
+ * Named setups of human bodies applied by SimulationCommand::SetupHuman
+ *
+ * Recordings refer to setups by name, so the app and replayers must add the same setups
+ * to their worlds (see SimulationReplayer::PrepareT)
+ */
+namespace human_setups {
+    static constexpr auto WALKER = "walker";
+
+    /**
+     * Periodic leg animation with tense holders of legs and arms
+     */
+    void walker(const PhysicSimulation::PhysicHumanBodyWP& body);
+
+    /**
+     * Add all setups to the simulation
+     */
+    void add_all(PhysicSimulation& simulation);
+}
@@ -16,6 +16,18 @@ public:
     virtual void update(const class PhysicBodyBase& body, double delta_time) = 0;
     virtual ~JointProcessor() = default;
 
+    /**
+     * Copy of the processor working with the same joint (used by PhysicSimulation snapshots)
+     */
+    virtual SharedPtr clone() const = 0;
+
+    /**
+     * Detached processor doesn't touch its joint in the destructor, so it may outlive the world
+     */
+    void detach() {
+        _detached = true;
+    }
+
     void delete_in_next_frame() {
         _should_be_deleted = true;
     }
@@ -25,7 +37,15 @@ public:
     }
 
 protected:
+    template <typename T>
+    SharedPtr clone_as() const {
+        auto copy = std::make_shared<T>(static_cast<const T&>(*this));
+        copy->_detached = false;
+        return copy;
+    }
+
     bool _should_be_deleted = false;
+    bool _detached          = false;
 };
 
 struct MotionFunction {
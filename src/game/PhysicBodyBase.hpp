@@ -1,6 +1,8 @@
 #pragma once
 
 #include <functional>
+#include <any>
+#include <vector>
 #include <scl/string.hpp>
 #include <scl/vector.hpp>
 
@@ -42,11 +44,31 @@ public:
         return _user_data;
     }
 
+    /**
+     * Index of the object in creation order of its PhysicSimulation, used by recorded commands
+     */
+    uint32_t object_id() const {
+        return _object_id;
+    }
+
 protected:
     void setWorld(class b2World* world) {_world = world; }
     virtual void destroy() = 0;
 
-    class b2World* _world = nullptr;
+    /**
+     * Own state of the derived body for PhysicSimulation snapshots,
+     * Box2D bodies, joints, user data and joint processors are saved by the simulation
+     */
+    virtual std::any save_state() const { return {}; }
+    virtual void restore_state(const std::any&) {}
+
+    /**
+     * Box2D bodies of the object, appended to dst
+     */
+    virtual void collect_bodies(std::vector<class b2Body*>& dst) const = 0;
+
+    class b2World* _world     = nullptr;
+    uint32_t       _object_id = 0;
 
     FunctionMap<void(PhysicBodyBase&, double)> _update_functions;
     HeterogenMap<std::string>                  _user_data;
@@ -64,6 +86,10 @@ public:
     void destroy() override;
 
 protected:
+    void collect_bodies(std::vector<class b2Body*>& dst) const override {
+        dst.push_back(_body);
+    }
+
     class b2Body* _body;
 };
 
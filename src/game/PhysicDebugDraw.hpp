@@ -0,0 +1,50 @@
+#pragma once
+
+class b2World;
+class b2Body;
+class b2Fixture;
+
+/**
+ * Debug draw backend of PhysicSimulation
+ *
+ * The simulation has no graphics dependencies, it only notifies the attached backend
+ * (e.g. SfmlPhysicDebugDraw from src/graphics) about fixtures and steps.
+ * The whole world is walked only by createObjects() when the debug draw is enabled or attached,
+ * creation and destruction of bodies are reported per body and per fixture.
+ */
+class PhysicDebugDraw {
+public:
+    virtual ~PhysicDebugDraw() = default;
+
+    /**
+     * Create drawables for fixtures of the world which have no drawable yet
+     */
+    virtual void createObjects(b2World& world) = 0;
+
+    /**
+     * Create drawables for fixtures of the new body, placed at its current transform
+     */
+    virtual void createBodyObjects(b2Body& body) = 0;
+
+    /**
+     * Remove the drawable of the fixture, called before the fixture is destroyed
+     */
+    virtual void destroyFixtureObjects(b2Fixture& fixture) = 0;
+
+    /**
+     * Move drawables to the current transforms of their bodies, called after every step
+     * @param world - world of the bodies, e.g. for broadphase queries of the visible area
+     */
+    virtual void update(b2World& world) = 0;
+
+    /**
+     * Place drawables between the previous and the current transforms of their bodies (between two steps)
+     * @param alpha - time since the last update in steps, [0, 1)
+     */
+    virtual void interpolate(double alpha) = 0;
+
+    /**
+     * Remove all drawables
+     */
+    virtual void clear() = 0;
+};
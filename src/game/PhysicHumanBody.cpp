@@ -1,7 +1,6 @@
 #include "PhysicHumanBody.hpp"
 
 #include <Box2D/Box2D.h>
-#include <random>
 #include "PhysicSimulation.hpp"
 
 #include "../core/math.hpp"
@@ -13,8 +12,8 @@ void SimpleBody::destroy() {
 }
 
 
-PhysicHumanBody::PhysicHumanBody(b2World& world, const b2Vec2& pos, float height, float mass) {
-    createHumanBody(world, pos, height, mass);
+PhysicHumanBody::PhysicHumanBody(b2World& world, uint32_t id, const b2Vec2& pos, float height, float mass) {
+    createHumanBody(world, id, pos, height, mass);
 
     _world = &world;
 
@@ -134,8 +133,6 @@ float32 PhysicHumanBody::RayCastCallback::ReportFixture(
     return fraction;
 }
 
-static auto rand_gen = std::bind(std::uniform_int_distribution<uint32_t>(1, std::numeric_limits<uint32_t>::min()), std::mt19937());
-
 auto PhysicHumanBody::createHumanBodyPart(b2World& world, uint32_t id, BodyPart type, const b2Vec2& pos, float height, float human_mass) {
     b2BodyDef body_def;
     body_def.type = b2_dynamicBody;
@@ -209,11 +206,9 @@ bool PhysicHumanBody::shouldCollide(b2Fixture* a, b2Fixture* b) {
     return true;
 }
 
-void PhysicHumanBody::createHumanBody(b2World& world, const b2Vec2& pos, float height, float mass) {
+void PhysicHumanBody::createHumanBody(b2World& world, uint32_t id, const b2Vec2& pos, float height, float mass) {
     scl::return_type_of_t<decltype(createHumanBodyPart)> parts[BodyPart_COUNT];
 
-    uint32_t id = rand_gen();
-
     for (size_t i = 0; i < BodyPart_COUNT; ++i) {
         parts[i] = createHumanBodyPart(world, id, BodyPart(i), pos, height, mass);
         _b2_parts[i] = parts[i].body;
@@ -243,6 +238,21 @@ void PhysicHumanBody::createHumanBody(b2World& world, const b2Vec2& pos, float h
 }
 
 
+std::any PhysicHumanBody::save_state() const {
+    auto state = SavedState{_left_orientation, _ground_raycast, {}};
+    std::copy(std::begin(_freezed_joints), std::end(_freezed_joints), state.freezed_joints.begin());
+
+    return state;
+}
+
+void PhysicHumanBody::restore_state(const std::any& state) {
+    auto& saved = std::any_cast<const SavedState&>(state);
+
+    _left_orientation = saved.left_orientation;
+    _ground_raycast   = saved.ground_raycast;
+    std::copy(saved.freezed_joints.begin(), saved.freezed_joints.end(), std::begin(_freezed_joints));
+}
+
 void PhysicHumanBody::makeMirror() {
     for (auto joint : _b2_joints) {
         auto l = joint->GetLowerLimit();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <Box2D/Common/b2Math.h>
 
 #include <scl/vector2.hpp>
@@ -298,7 +299,14 @@ public:
     template <typename T>
     using JointTraverseF = std::function<T(const T& val, class b2Joint*)>;
 
-    PhysicHumanBody(class b2World& world, const b2Vec2& pos, float height = 1.8f, float mass = 80.f);
+    /**
+     * @param world - Box2D world
+     * @param id - id unique in the world, parts with the same id don't collide with each other
+     * @param pos - position
+     * @param height - human height
+     * @param mass - human mass
+     */
+    PhysicHumanBody(class b2World& world, uint32_t id, const b2Vec2& pos, float height = 1.8f, float mass = 80.f);
 
     void makeMirror();
 
@@ -364,8 +372,17 @@ public:
 protected:
     void destroy() override;
 
+    std::any save_state() const override;
+    void restore_state(const std::any& state) override;
+
+    void collect_bodies(std::vector<class b2Body*>& dst) const override {
+        for (auto part : _b2_parts)
+            if (part)
+                dst.push_back(part);
+    }
+
 private:
-    void createHumanBody           (class b2World& world, const b2Vec2& pos, float height, float mass);
+    void createHumanBody           (class b2World& world, uint32_t id, const b2Vec2& pos, float height, float mass);
     static auto createHumanBodyPart(class b2World& world, uint32_t id, BodyPart type, const b2Vec2& pos, float height, float human_mass);
     static bool shouldCollide      (class b2Fixture* a, class b2Fixture* b);
 
@@ -406,4 +423,10 @@ private:
     class b2Body* _b2_parts [BodyPart_COUNT] = {nullptr};
     class b2RevoluteJoint* _b2_joints[BodyJoint_COUNT] = {nullptr};
     bool _freezed_joints[BodyJoint_COUNT] = {false};
+
+    struct SavedState {
+        bool                      left_orientation;
+        decltype(_ground_raycast) ground_raycast;
+        std::array<bool, BodyJoint_COUNT> freezed_joints;
+    };
 };
\ No newline at end of file
@@ -1,12 +1,11 @@
 #include "PhysicSimulation.hpp"
 
+#include <cmath>
 #include <Box2D/Box2D.h>
-#include <SFML/Graphics/ConvexShape.hpp>
-#include <SFML/Graphics/CircleShape.hpp>
-#include <SFML/Graphics/Texture.hpp>
 
 #include "PhysicHumanBody.hpp"
-#include "../core/math.hpp"
+#include "HolderJointProcessor.hpp"
+#include "SimulationRecording.hpp"
 
 
 #define MASS_FACT 0.01f
@@ -18,6 +17,21 @@ public:
     }
 };
 
+// Removes drawables of fixtures destroyed with their bodies
+class DestructionListener : public b2DestructionListener {
+public:
+    explicit DestructionListener(PhysicSimulation& simulation): _simulation(simulation) {}
+
+    void SayGoodbye(b2Joint*) override {}
+
+    void SayGoodbye(b2Fixture* fixture) override {
+        _simulation.destroyDebugDrawObjects(*fixture);
+    }
+
+private:
+    PhysicSimulation& _simulation;
+};
+
 
 static b2Body* createBox(b2World& world, const b2Vec2& pos, float mass, const b2Vec2& size, const b2Vec2& velocity) {
     b2BodyDef body_def;
@@ -63,10 +77,13 @@ PhysicSimulation::PhysicSimulation() {
 
     _contact_filter = std::make_unique<ContactFilter>();
     _world->SetContactFilter(_contact_filter.get());
+
+    _destruction_listener = std::make_unique<DestructionListener>(*this);
+    _world->SetDestructionListener(_destruction_listener.get());
 }
 
 PhysicSimulation::~PhysicSimulation() {
-    clearDrawableManager();
+    clearDebugDraw();
 }
 
 auto PhysicSimulation::createTestSimulation() -> PhysicSimulation::UniquePtr {
@@ -104,32 +121,34 @@ void PhysicSimulation::update() {
     if (!_world)
         return;
 
+    auto tick = _timer.tick().sec();
+
     if (_on_pause) {
-        _timer.tick().sec();
         return;
     }
     else if (_force_update) {
-        _timer.tick().sec();
         step(_step_time);
+        _timestep_accumulator = 0.0;
+        return;
     }
-    else {
-        auto tick = _timer.tick().sec() / _slowdown_factor;
 
-        if (_adaptive_timestep && tick > _step_time) {
-            step(tick);
-            _timestep_accumulator = 0.0;
-        }
-        else if (_timestep_accumulator > _step_time) {
-            _timestep_accumulator -= _step_time * int64_t(_timestep_accumulator / _step_time);
-            step(_step_time);
-        }
-        else {
-            if (_debug_draw)
-                interpolateDebugDraw(tick);
-        }
+    _timestep_accumulator += tick / _slowdown_factor;
 
-        _timestep_accumulator += tick;
+    // Steps are always step_time long, so the result doesn't depend on the frame rate
+    uint32_t steps = 0;
+
+    while (_timestep_accumulator >= _step_time && steps < _max_catch_up_steps) {
+        step(_step_time);
+        _timestep_accumulator -= _step_time;
+        ++steps;
     }
+
+    // Time which can't be caught up is dropped, otherwise every next update would be late too
+    if (_timestep_accumulator >= _step_time)
+        _timestep_accumulator = std::fmod(_timestep_accumulator, _step_time);
+
+    if (_debug_draw)
+        interpolateDebugDraw(_timestep_accumulator / _step_time);
 }
 
 void PhysicSimulation::step(double delta_time) {
@@ -139,78 +158,208 @@ void PhysicSimulation::step(double delta_time) {
     if (delta_time > MIN_STEP)
         delta_time = MIN_STEP; // Prevent from box2d low-timestep glitches
 
+    auto milliseconds = [](const Timestamp& from, const Timestamp& to) {
+        return float((to - from).sec() * 1000.0);
+    };
+
+    auto start = timer().timestamp();
+
     for (auto& body : _bodies.data()) {
         body->_update_functions.foreach([body, delta_time](const std::function<void(PhysicBodyBase&, double)>& f) {
             f(*(body.get()), delta_time);
         });
     }
 
+    auto bodies_end = timer().timestamp();
+
+    // Without warm starting joints start from zero impulses, as on the first step of a new world
+    if (_reset_warm_starting)
+        _world->SetWarmStarting(false);
+
     _world->Step(float(delta_time), _velocity_iters, _position_iters);
     _simulation_time += delta_time;
 
+    if (_reset_warm_starting) {
+        _world->SetWarmStarting(true);
+        _reset_warm_starting = false;
+    }
+
+    if (_recording)
+        _recording->recordStep(delta_time, *this);
+
+    auto callbacks_start = timer().timestamp();
+
     for (auto& pair : _post_callbacks)
         pair.second(*this);
 
+    auto callbacks_end = timer().timestamp();
+
     if (_debug_draw)
         updateDebugDraw();
+
+    auto end = timer().timestamp();
+
+    // Box2D measures its parts itself
+    auto& world_profile = _world->GetProfile();
+
+    auto profile = StepProfile();
+    profile.step       = milliseconds(start, end);
+    profile.bodies     = milliseconds(start, bodies_end);
+    profile.world      = world_profile.step;
+    profile.collide    = world_profile.collide;
+    profile.solve      = world_profile.solve;
+    profile.solve_toi  = world_profile.solveTOI;
+    profile.broadphase = world_profile.broadphase;
+    profile.callbacks  = milliseconds(callbacks_start, callbacks_end);
+    profile.debug_draw = milliseconds(callbacks_end, end);
+
+    _profiler.push(profile);
 }
 
 
-void PhysicSimulation::attachDrawableManager(const DrawableManagerSP& drawable_manager)  {
-    if (_drawable_manager == drawable_manager)
-        return;
+auto PhysicSimulation::snapshot() const -> Snapshot {
+    Snapshot result;
+    snapshot(result);
+    return result;
+}
 
-    clearDrawableManager();
+void PhysicSimulation::snapshot(Snapshot& dst) const {
+    dst.bodies.clear();
+    dst.joints.clear();
+    dst.objects.clear();
 
-    _drawable_manager = drawable_manager;
+    for (auto body = _world->GetBodyList(); body; body = body->GetNext()) {
+        auto& pos = body->GetPosition();
+        auto& vel = body->GetLinearVelocity();
 
-    // Reset debug draw;
-    if (_debug_draw) {
-        _debug_draw = false;
-        enableDebugDraw();
+        dst.bodies.push_back({pos.x, pos.y, body->GetAngle(), vel.x, vel.y, body->GetAngularVelocity(), body->IsAwake()});
     }
-}
 
+    for (auto joint = _world->GetJointList(); joint; joint = joint->GetNext()) {
+        auto state = Snapshot::JointState{};
 
-auto PhysicSimulation::detachDrawableManager()  {
-    clearDrawableManager();
+        if (joint->GetType() == e_revoluteJoint) {
+            auto revolute = static_cast<b2RevoluteJoint*>(joint);
 
-    DrawableManagerSP res = _drawable_manager;
-    _drawable_manager = nullptr;
-    return res;
+            state.motor_speed      = revolute->GetMotorSpeed();
+            state.max_motor_torque = revolute->GetMaxMotorTorque();
+            state.lower_limit      = revolute->GetLowerLimit();
+            state.upper_limit      = revolute->GetUpperLimit();
+            state.motor_enabled    = revolute->IsMotorEnabled();
+            state.limit_enabled    = revolute->IsLimitEnabled();
+        }
+
+        dst.joints.push_back(state);
+    }
+
+    for (auto& object : _bodies.data()) {
+        auto& state = dst.objects.emplace_back();
+
+        state.object    = object.get();
+        state.user_data = object->_user_data;
+        state.state     = object->save_state();
+
+        if (auto with_joints = dynamic_cast<const BodyWithJoints*>(object.get())) {
+            for (auto& [name, processor] : with_joints->_jpm.data()) {
+                auto copy = processor->clone();
+                copy->detach();
+                state.joint_processors.emplace_back(name, std::move(copy));
+            }
+        }
+    }
+
+    dst.simulation_time      = _simulation_time;
+    dst.timestep_accumulator = _timestep_accumulator;
 }
 
-static void setSfmlConvexFromB2Polygon(sf::ConvexShape* cvx, b2PolygonShape* poly) {
-    cvx->setPointCount(size_t(poly->m_count));
+void PhysicSimulation::restore(const Snapshot& snapshot) {
+    if (size_t(_world->GetBodyCount())  != snapshot.bodies.size() ||
+        size_t(_world->GetJointCount()) != snapshot.joints.size() ||
+        _bodies.data().size()           != snapshot.objects.size())
+        throw std::runtime_error("PhysicSimulation::restore(): snapshot doesn't match the world");
+
+    // Objects first: removed joint processors disable motors of their joints
+    auto object_state = snapshot.objects.begin();
 
-    for (int i = 0; i < poly->m_count; ++i) {
-        b2Vec2 pos = poly->m_vertices[i];
-        cvx->setPoint(size_t(i), sf::Vector2f(pos.x, -pos.y));
+    for (auto& object : _bodies.data()) {
+        if (object.get() != object_state->object)
+            throw std::runtime_error("PhysicSimulation::restore(): snapshot doesn't match the world");
+
+        object->_user_data = object_state->user_data;
+        object->restore_state(object_state->state);
+
+        if (auto with_joints = dynamic_cast<BodyWithJoints*>(object.get())) {
+            auto& processors = with_joints->_jpm.data();
+            processors.clear();
+
+            for (auto& [name, processor] : object_state->joint_processors)
+                processors.emplace(name, processor->clone());
+        }
+
+        ++object_state;
     }
+
+    restoreWorld(snapshot);
+
+    _timestep_accumulator = snapshot.timestep_accumulator;
+
+    updateDebugDraw();
 }
 
-static void setSfmlCircle(sf::ConvexShape* cvx, float radius, size_t points_count = 32) {
-    cvx->setPointCount(points_count + 4);
+void PhysicSimulation::restoreWorld(const Snapshot& snapshot) {
+    if (size_t(_world->GetBodyCount())  != snapshot.bodies.size() ||
+        size_t(_world->GetJointCount()) != snapshot.joints.size())
+        throw std::runtime_error("PhysicSimulation::restoreWorld(): snapshot doesn't match the world");
 
-    float angle = 0;
-    float delta = M_PIf32 * 2 / points_count;
-    float epsilon = 0.001f;
+    auto body_state = snapshot.bodies.begin();
 
-    for (size_t i = 0; i < points_count; ++i) {
-        cvx->setPoint(i, {cos(angle) * radius, sin(angle) * radius});
-        angle += delta;
+    for (auto body = _world->GetBodyList(); body; body = body->GetNext(), ++body_state) {
+        // Deactivation destroys contacts of the body with their cached impulses, the next step finds
+        // contacts from scratch as in a freshly built world
+        auto active = body->IsActive();
+        body->SetActive(false);
+
+        body->SetTransform(b2Vec2(body_state->x, body_state->y), body_state->angle);
+        body->SetLinearVelocity(b2Vec2(body_state->linear_velocity_x, body_state->linear_velocity_y));
+        body->SetAngularVelocity(body_state->angular_velocity);
+
+        body->SetActive(active);
+        body->SetAwake(body_state->awake);
     }
 
-    // Draw line
-    cvx->setPoint(points_count    , {radius, 0});
-    cvx->setPoint(points_count + 1, {0, 0});
-    cvx->setPoint(points_count + 2, {0, 0});
-    cvx->setPoint(points_count + 3, {radius, 0});
+    auto joint_state = snapshot.joints.begin();
+
+    for (auto joint = _world->GetJointList(); joint; joint = joint->GetNext(), ++joint_state) {
+        if (joint->GetType() != e_revoluteJoint)
+            continue;
+
+        auto revolute = static_cast<b2RevoluteJoint*>(joint);
+
+        revolute->SetMotorSpeed(joint_state->motor_speed);
+        revolute->SetMaxMotorTorque(joint_state->max_motor_torque);
+        revolute->SetLimits(joint_state->lower_limit, joint_state->upper_limit);
+        revolute->EnableMotor(joint_state->motor_enabled);
+        revolute->EnableLimit(joint_state->limit_enabled);
+    }
+
+    _simulation_time     = snapshot.simulation_time;
+    _reset_warm_starting = true;
+}
+
+void PhysicSimulation::attachDebugDraw(PhysicDebugDrawUP debug_draw) {
+    clearDebugDraw();
+
+    _debug_drawer = std::move(debug_draw);
+
+    if (_debug_draw) {
+        createDebugDrawObjects();
+        updateDebugDraw();
+    }
 }
 
-static void setSfmlFromB2(sf::ConvexShape* sf_circ, b2CircleShape* b2_circ) {
-    setSfmlCircle(sf_circ, b2_circ->m_radius);
-    sf_circ->setPosition(b2_circ->m_p.x, -b2_circ->m_p.y);
+auto PhysicSimulation::detachDebugDraw() -> PhysicDebugDrawUP {
+    clearDebugDraw();
+    return std::move(_debug_drawer);
 }
 
 void PhysicSimulation::debug_draw(bool value) {
@@ -220,11 +369,9 @@ void PhysicSimulation::debug_draw(bool value) {
         disableDebugDraw();
 }
 
-void PhysicSimulation::clearDrawableManager() {
-    for (auto pair : _draw_map)
-        _drawable_manager->remove(pair.second);
-
-    _draw_map.clear();
+void PhysicSimulation::clearDebugDraw() {
+    if (_debug_drawer)
+        _debug_drawer->clear();
 }
 
 void PhysicSimulation::disableDebugDraw() {
@@ -233,167 +380,223 @@ void PhysicSimulation::disableDebugDraw() {
 
     _debug_draw = false;
 
-    if (!_drawable_manager)
-        return;
-
-    clearDrawableManager();
-
-    _debug_draw = false;
+    clearDebugDraw();
 }
 
-
 void PhysicSimulation::enableDebugDraw() {
     if (_debug_draw)
         return;
 
     _debug_draw = true;
 
-    if (!_drawable_manager)
-        return;
-
     createDebugDrawObjects();
     updateDebugDraw();
 }
 
 void PhysicSimulation::createDebugDrawObjects() {
-    if (!_debug_draw)
+    if (_debug_draw && _debug_drawer)
+        _debug_drawer->createObjects(*_world);
+}
+
+void PhysicSimulation::createDebugDrawObjects(const PhysicBodyBase& object) {
+    if (!_debug_draw || !_debug_drawer)
         return;
 
-    auto body = _world->GetBodyList();
+    _object_bodies.clear();
+    object.collect_bodies(_object_bodies);
 
-    while (body) {
-        auto fixtures = body->GetFixtureList();
+    for (auto body : _object_bodies)
+        _debug_drawer->createBodyObjects(*body);
+}
 
-        while (fixtures) {
-            if (_draw_map.find(fixtures) != _draw_map.end()) {
-                fixtures = fixtures->GetNext();
-                continue;
-            }
+void PhysicSimulation::destroyDebugDrawObjects(b2Fixture& fixture) {
+    if (_debug_draw && _debug_drawer)
+        _debug_drawer->destroyFixtureObjects(fixture);
+}
 
-            sf::Shape* shape = nullptr;
+void PhysicSimulation::updateDebugDraw() {
+    if (_debug_draw && _debug_drawer)
+        _debug_drawer->update(*_world);
+}
 
-            switch (fixtures->GetType()) {
-                case b2Shape::e_polygon: {
-                    auto cvx_shape = _drawable_manager->create<sf::ConvexShape>();
-                    shape = cvx_shape;
+void PhysicSimulation::interpolateDebugDraw(double alpha) {
+    if (_debug_draw && _debug_drawer)
+        _debug_drawer->interpolate(alpha);
+}
 
-                    _draw_map[fixtures] = cvx_shape;
-                    setSfmlConvexFromB2Polygon(cvx_shape, reinterpret_cast<b2PolygonShape*>(fixtures->GetShape()));
-                } break;
+auto PhysicSimulation::spawnBox(float x, float y, float mass, scl::Vector2f velocity) -> PhysicSimpleBodyWP {
+    if (_recording) {
+        auto command = SimulationCommand{SimulationCommand::SpawnBox};
+        command.values = {x, y, mass, velocity.x(), velocity.y()};
+        _recording->recordCommand(command);
+    }
 
-                case b2Shape::e_circle: {
-                    auto sf_shape = _drawable_manager->create<sf::ConvexShape>();
-                    shape = sf_shape;
+    auto ptr = createBox(*_world, b2Vec2(x, y), mass * MASS_FACT, b2Vec2(0.1f, 0.1f), b2Vec2{velocity.x(), velocity.y()});
+    auto res = _bodies.create<SimpleBody>(_world.get(), ptr);
+    res.lock()->_object_id = uint32_t(_objects.size());
+    _objects.push_back(res);
 
-                    _draw_map[fixtures] = sf_shape;
-                    setSfmlFromB2(sf_shape, reinterpret_cast<b2CircleShape*>(fixtures->GetShape()));
-                } break;
+    createDebugDrawObjects(*res.lock());
 
-                default:
-                    std::cout << "\t\tUnhandled shape" << std::endl;
-                    break;
-            }
+    return res;
+}
 
-            if (shape) {
-                if (fixtures->GetBody()->GetType() == b2_dynamicBody) {
-                    auto color = sf::Color::Green;
-                    color.a = 30;
-                    shape->setFillColor(color);
-                    shape->setOutlineColor(sf::Color::Green);
-                    shape->setOutlineThickness(-0.02f);
-                }
-                else {
-                    auto color = sf::Color::Magenta;
-                    color.a = 30;
-                    shape->setFillColor(color);
-                    shape->setOutlineColor(sf::Color::Magenta);
-                    shape->setOutlineThickness(-0.02f);
-                }
-            }
+auto PhysicSimulation::createHumanBody(const scl::Vector2f& position, float height, float mass) -> PhysicHumanBodyWP {
+    if (_recording) {
+        auto command = SimulationCommand{SimulationCommand::CreateHumanBody};
+        command.values = {position.x(), position.y(), height, mass};
+        _recording->recordCommand(command);
+    }
+
+    auto res = _bodies.create<PhysicHumanBody>(*_world, _next_body_id++, b2Vec2{position.x(), position.y()}, height, mass);
+    res.lock()->_object_id = uint32_t(_objects.size());
+    _objects.push_back(res);
+
+    createDebugDrawObjects(*res.lock());
 
-            fixtures = fixtures->GetNext();
+    return res;
+}
+
+void PhysicSimulation::deleteBody(std::weak_ptr<PhysicBodyBase> body) {
+    if (auto lock = body.lock()) {
+        if (_recording) {
+            auto command = SimulationCommand{SimulationCommand::DeleteBody};
+            command.object = lock->_object_id;
+            _recording->recordCommand(command);
         }
 
-        body = body->GetNext();
+        // Drawables of the fixtures are removed by the destruction listener
+        lock.get()->destroy();
+
+        _bodies.erase(lock);
     }
 }
 
-void PhysicSimulation::updateDebugDraw() {
-    if (!_debug_draw)
-        return;
+void PhysicSimulation::gravity(float x, float y) {
+    if (_recording) {
+        auto command = SimulationCommand{SimulationCommand::SetGravity};
+        command.values = {x, y};
+        _recording->recordCommand(command);
+    }
 
-    for (auto pair : _draw_map) {
-         b2Fixture*    b2_fixture  = pair.first;
-         sf::Drawable* sf_drawable = pair.second;
+    _world->SetGravity(b2Vec2(x, y));
+}
+
+auto PhysicSimulation::object(uint32_t id) const -> PhysicBodyBaseWP {
+    return id < _objects.size() ? _objects[id] : PhysicBodyBaseWP();
+}
+
+void PhysicSimulation::execute(const SimulationCommand& command) {
+    auto& v = command.values;
+
+    switch (command.type) {
+        case SimulationCommand::SpawnBox:
+            spawnBox(v[0], v[1], v[2], {v[3], v[4]});
+            return;
 
-         b2Vec2 b2_pos = b2_fixture->GetBody()->GetPosition();
+        case SimulationCommand::CreateHumanBody:
+            createHumanBody({v[0], v[1]}, v[2], v[3]);
+            return;
 
-         if (b2_fixture->GetType() == b2Shape::e_polygon) {
-             auto b2_shape = reinterpret_cast<b2PolygonShape*>(b2_fixture->GetShape());
-             auto sf_shape = reinterpret_cast<sf::ConvexShape*>(sf_drawable);
+        case SimulationCommand::DeleteBody:
+            deleteBody(object(command.object));
+            return;
 
-             sf_shape->setPosition(b2_pos.x, -b2_pos.y);
-             sf_shape->setRotation(-b2_fixture->GetBody()->GetAngle() * 180.f / M_PIf32);
-         }
-         else if (b2_fixture->GetType() == b2Shape::e_circle) {
-             auto b2_shape = reinterpret_cast<b2CircleShape*>(b2_fixture->GetShape());
-             auto sf_shape = reinterpret_cast<sf::CircleShape*>(sf_drawable);
+        case SimulationCommand::SetGravity:
+            gravity(v[0], v[1]);
+            return;
 
-             sf_shape->setPosition(b2_pos.x, -b2_pos.y);
-             sf_shape->setRotation(-b2_fixture->GetBody()->GetAngle() * 180 / M_PIf32);
-         }
+        case SimulationCommand::SetIterations:
+            _velocity_iters = int32_t(v[0]);
+            _position_iters = int32_t(v[1]);
+
+            if (_recording)
+                _recording->recordCommand(command);
+            return;
+
+        default:
+            break;
     }
-}
 
-void PhysicSimulation::interpolateDebugDraw(double timestep) {
-    if (!_debug_draw)
-        return;
+    auto human = std::dynamic_pointer_cast<PhysicHumanBody>(object(command.object).lock());
+    if (!human)
+        throw std::runtime_error("PhysicSimulation::execute(): object " + std::to_string(command.object) +
+                                 " is not an existing human body");
 
-    for (auto pair : _draw_map) {
-        b2Fixture*    b2_fixture  = pair.first;
-        sf::Drawable* sf_drawable = pair.second;
+    // Indices may come from a recording file, they index arrays of the body
+    auto uses_joint = command.type == SimulationCommand::EnableMotor || command.type == SimulationCommand::DisableMotor ||
+                      command.type == SimulationCommand::Freeze      || command.type == SimulationCommand::Unfreeze;
+    auto uses_part  = command.type == SimulationCommand::ApplyImpulse;
 
-        b2Vec2 linear_move = b2_fixture->GetBody()->GetLinearVelocity();
-        linear_move *= timestep;
+    if ((uses_joint && command.index >= PhysicHumanBody::BodyJoint_COUNT) ||
+        (uses_part  && command.index >= PhysicHumanBody::BodyPart_COUNT))
+        throw std::runtime_error("PhysicSimulation::execute(): index " + std::to_string(command.index) +
+                                 " is out of range for object " + std::to_string(command.object));
 
-        float angular_move = math::angle::degree(-b2_fixture->GetBody()->GetAngularVelocity() * float(timestep));
+    auto joint = PhysicHumanBody::BodyJoint(command.index);
 
-        auto sf_shape = reinterpret_cast<sf::Shape*>(sf_drawable);
+    switch (command.type) {
+        case SimulationCommand::ApplyImpulse:
+            human->apply_impulse(PhysicHumanBody::BodyPart(command.index), {v[0], v[1]}, {v[2], v[3]}, command.flag);
+            break;
 
-        sf_shape->move({linear_move.x, -linear_move.y});
-        sf_shape->rotate(angular_move);
-    }
-}
+        case SimulationCommand::EnableMotor:
+            human->enableMotor(joint, v[0], v[1]);
+            break;
 
-auto PhysicSimulation::spawnBox(float x, float y, float mass, scl::Vector2f velocity) -> PhysicSimpleBodyWP {
-    auto ptr = createBox(*_world, b2Vec2(x, y), mass * MASS_FACT, b2Vec2(0.1f, 0.1f), b2Vec2{velocity.x(), velocity.y()});
-    createDebugDrawObjects();
-    updateDebugDraw();
+        case SimulationCommand::DisableMotor:
+            human->disableMotor(joint);
+            break;
 
-    return _bodies.create<SimpleBody>(_world.get(), ptr);
-}
+        case SimulationCommand::Mirror:
+            human->makeMirror();
+            break;
 
-auto PhysicSimulation::createHumanBody(const scl::Vector2f& position, float height, float mass) -> PhysicHumanBodyWP {
-    auto res = _bodies.create<PhysicHumanBody>(*_world, b2Vec2{position.x(), position.y()}, height, mass);
+        case SimulationCommand::HoldAngle:
+            if (auto processor = human->joint_processor_cast_get<HolderJointProcessor>(command.name).lock())
+                processor->hold_angle(v[0]);
+            break;
 
-    createDebugDrawObjects();
-    updateDebugDraw();
+        case SimulationCommand::Freeze:
+            human->freeze(joint);
+            break;
 
-    return res;
-}
+        case SimulationCommand::Unfreeze:
+            human->unfreeze(joint);
+            break;
 
-void PhysicSimulation::deleteBody(std::weak_ptr<PhysicBodyBase> body) {
-    if (auto lock = body.lock()) {
-        lock.get()->destroy();
+        case SimulationCommand::SetupHuman: {
+            auto setup = _human_setups.find(command.name);
+            if (setup == _human_setups.end())
+                throw std::runtime_error("PhysicSimulation::execute(): unknown human setup " + command.name);
 
-        _bodies.erase(lock);
+            setup->second(human);
+            break;
+        }
+
+        default:
+            throw std::runtime_error("PhysicSimulation::execute(): unknown command type");
     }
 
-    clearDrawableManager();
-    createDebugDrawObjects();
-    updateDebugDraw();
+    if (_recording)
+        _recording->recordCommand(command);
 }
 
-void PhysicSimulation::gravity(float x, float y) {
-    _world->SetGravity(b2Vec2(x, y));
+void PhysicSimulation::startRecording(size_t keyframe_interval) {
+    if (!_objects.empty())
+        throw std::logic_error("PhysicSimulation::startRecording(): world already has objects");
+
+    auto settings = SimulationRecording::Settings();
+    auto gravity  = _world->GetGravity();
+
+    settings.gravity_x      = gravity.x;
+    settings.gravity_y      = gravity.y;
+    settings.velocity_iters = _velocity_iters;
+    settings.position_iters = _position_iters;
+
+    _recording = std::make_unique<SimulationRecording>(settings, keyframe_interval);
+}
+
+auto PhysicSimulation::stopRecording() -> RecordingUP {
+    return std::move(_recording);
 }
\ No newline at end of file
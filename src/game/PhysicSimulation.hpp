@@ -1,42 +1,47 @@
 #pragma once
 
 #include <mutex>
+#include <algorithm>
 
 #include <flat_hash_map.hpp>
 #include <memory>
 
-#include "../graphics/DrawableManager.hpp"
+#include "PhysicDebugDraw.hpp"
+#include "PhysicBodyBase.hpp"
+#include "StepProfiler.hpp"
 
 #include "../core/helper_macros.hpp"
 #include "../core/time.hpp"
 #include "../core/DerivedObjectManager.hpp"
 
-namespace sf {
-    class Drawable;
-    class ConvexShape;
-}
-
 class b2World;
+class b2Body;
 class b2Fixture;
-class b2PolygonShape;
+struct SimulationCommand;
+class SimulationRecording;
 
 class PhysicSimulation {
+    friend class DestructionListener;
+
 public:
     static constexpr float MASS_FACTOR = 0.01;
     static constexpr float MIN_STEP    = 1/15.f;
 
-    using DrawableManagerSP = std::shared_ptr<DrawableManager>;
+    using PhysicDebugDrawUP = std::unique_ptr<PhysicDebugDraw>;
     using B2WorldUP         = std::unique_ptr<b2World>;
     using PhysicBodyBaseWP  = std::weak_ptr<class PhysicBodyBase>;
     using PhysicHumanBodyWP = std::weak_ptr<class PhysicHumanBody>;
     using PhysicSimpleBodyWP = std::weak_ptr<class SimpleBody>;
     using ContactFilterUP   = std::unique_ptr<class ContactFilter>;
+    using DestructionListenerUP = std::unique_ptr<class DestructionListener>;
 
     using UpdatePostCallbackT = std::function<void(PhysicSimulation&)>;
+    using HumanSetupT         = std::function<void(const PhysicHumanBodyWP&)>;
+    using RecordingUP         = std::unique_ptr<SimulationRecording>;
 
-    DrawableManagerSP _drawable_manager;
-    B2WorldUP         _world;
-    ContactFilterUP   _contact_filter;
+    B2WorldUP             _world;
+    ContactFilterUP       _contact_filter;
+    DestructionListenerUP _destruction_listener;
 
     // Fabric methods
 public:
@@ -45,6 +50,86 @@ public:
 
     PhysicSimpleBodyWP spawnBox(float x, float y, float mass = 1.0f, scl::Vector2f velocity = {0, 0});
 
+    /**
+     * Apply the command, it is recorded if the recording is started
+     */
+    void execute(const SimulationCommand& command);
+
+    /**
+     * Object by its object_id()
+     */
+    PhysicBodyBaseWP object(uint32_t id) const;
+
+    /**
+     * Start recording of steps and commands (see SimulationRecording)
+     * World must have no objects, replay starts from createTestSimulation()
+     * @param keyframe_interval - steps between state keyframes
+     */
+    void startRecording(size_t keyframe_interval = 100);
+    RecordingUP stopRecording();
+
+    bool recording() const {
+        return _recording != nullptr;
+    }
+
+public:
+    /**
+     * State of the world for restore() into the same world, bodies and joints must not be created or destroyed
+     * in between. Contact cache and warm starting impulses of joints are internal Box2D state and are not saved:
+     * restore() drops them, so the restored world continues with the solver state of a freshly built one
+     * (contacts are found again, joints start from zero impulses), but not bit-identically to the original run.
+     */
+    struct Snapshot {
+        struct BodyState {
+            float x, y, angle;
+            float linear_velocity_x, linear_velocity_y, angular_velocity;
+            bool  awake;
+        };
+
+        // Only revolute joints have motor and limits
+        struct JointState {
+            float motor_speed, max_motor_torque;
+            float lower_limit, upper_limit;
+            bool  motor_enabled, limit_enabled;
+        };
+
+        struct ObjectState {
+            const PhysicBodyBase*     object;
+            HeterogenMap<std::string> user_data;
+            std::any                  state;
+
+            // Detached copies, they are cloned again on every restore
+            std::vector<std::pair<std::string, JointProcessor::SharedPtr>> joint_processors;
+        };
+
+        std::vector<BodyState>   bodies;
+        std::vector<JointState>  joints;
+        std::vector<ObjectState> objects;
+
+        double simulation_time      = 0;
+        double timestep_accumulator = 0;
+    };
+
+    Snapshot snapshot() const;
+
+    /**
+     * Save the state into the existing snapshot, its buffers are reused
+     */
+    void snapshot(Snapshot& dst) const;
+
+    /**
+     * Restore the state saved by snapshot() of this world
+     * Throws std::runtime_error if the world structure was changed
+     */
+    void restore(const Snapshot& snapshot);
+
+    /**
+     * Restore only bodies, joints and simulation time of the snapshot, objects keep their state
+     * Used for keyframes of SimulationRecording, which don't hold the state of objects
+     * Throws std::runtime_error if counts of bodies and joints don't match the snapshot
+     */
+    void restoreWorld(const Snapshot& snapshot);
+
 public:
     DECLARE_SELF_FABRICS(PhysicSimulation);
 
@@ -53,12 +138,21 @@ public:
     PhysicSimulation();
     ~PhysicSimulation();
 
-    void attachDrawableManager(const DrawableManagerSP& drawable_manager);
-    auto detachDrawableManager();
-
+    /**
+     * Attach debug draw backend, the simulation itself doesn't depend on graphics
+     * @param debug_draw - backend (e.g. SfmlPhysicDebugDraw)
+     */
+    void attachDebugDraw(PhysicDebugDrawUP debug_draw);
+    PhysicDebugDrawUP detachDebugDraw();
+
+    /**
+     * Fixed step scheduler: real time since the last update (slowed down by slowdown_factor) is accumulated
+     * and simulated with steps of step_time, at most max_catch_up_steps per update. The remainder of the
+     * accumulator is passed to the debug draw for interpolation between the last two steps.
+     */
     void update();
     void step(double delta_time);
-    void step() { step(_step_time / _slowdown_factor); }
+    void step() { step(_step_time); }
 
     double simulation_time() {
         return _simulation_time;
@@ -72,34 +166,71 @@ public:
         _post_callbacks.erase(name);
     }
 
+    /**
+     * Named setup of a created human (joint processors, motion interfaces), applied by
+     * the SimulationCommand::SetupHuman command, so it is recorded and replayed by name
+     */
+    void addHumanSetup(const std::string& name, const HumanSetupT& setup) {
+        _human_setups.emplace(name, setup);
+    }
+
+    void removeHumanSetup(const std::string& name) {
+        _human_setups.erase(name);
+    }
+
+    /**
+     * Timings of the last steps (see StepProfile)
+     */
+    const StepProfiler& profiler() const {
+        return _profiler;
+    }
+
+    StepProfiler& profiler() {
+        return _profiler;
+    }
+
 private:
     void enableDebugDraw();
     void disableDebugDraw();
     void createDebugDrawObjects();
+    void createDebugDrawObjects(const PhysicBodyBase& object);
+    void destroyDebugDrawObjects(b2Fixture& fixture);
     void updateDebugDraw();
-    void clearDrawableManager();
-    void interpolateDebugDraw(double timestep);
+    void clearDebugDraw();
+    void interpolateDebugDraw(double alpha);
 
 private:
     DerivedObjectManager<class PhysicBodyBase> _bodies;
 
-    ska::flat_hash_map<b2Fixture*, sf::Drawable*> _draw_map;
+    PhysicDebugDrawUP _debug_drawer;
     ska::flat_hash_map<std::string, UpdatePostCallbackT> _post_callbacks;
+    ska::flat_hash_map<std::string, HumanSetupT>         _human_setups;
     bool _debug_draw = false;
     bool _on_pause   = false;
-    bool _adaptive_timestep = true;
     bool _force_update = false;
-    bool _interpolation = false;
 
     int32_t _velocity_iters  = 8;
     int32_t _position_iters  = 3;
     double  _simulation_time = 0;
     double  _slowdown_factor = 1.0;
 
-    double _step_time = 1.f/100.0;
-    double _timestep_accumulator = 0.f;
+    bool     _reset_warm_starting = false; // First step after restore() starts joints from zero impulses
+    double   _step_time = 1.f/100.0;
+    double   _timestep_accumulator = 0.f;
+    uint32_t _max_catch_up_steps = 5;
     Timer  _timer;
 
+    StepProfiler _profiler;
+
+    // Ids of human bodies are unique per world, so creation order alone defines them
+    uint32_t _next_body_id = 1;
+
+    // All created objects in creation order, index is object_id()
+    std::vector<PhysicBodyBaseWP> _objects;
+    RecordingUP                   _recording;
+
+    std::vector<b2Body*> _object_bodies; // Scratch for createDebugDrawObjects()
+
 public:
     // Getters / setters
     void debug_draw(bool value);
@@ -107,9 +238,13 @@ public:
 
     DECLARE_GET_SET(velocity_iters);
     DECLARE_GET_SET(position_iters);
-    DECLARE_GET_SET(step_time);
+    DECLARE_GET(step_time);
+
+    // step() clamps longer steps to MIN_STEP, so the fixed step can't be longer
+    void step_time(double value) { _step_time = std::min(value, double(MIN_STEP)); }
+
     DECLARE_GET_SET(on_pause);
-    DECLARE_GET_SET(adaptive_timestep);
+    DECLARE_GET_SET(max_catch_up_steps);
     DECLARE_GET_SET(slowdown_factor);
     DECLARE_GET_SET(force_update);
 
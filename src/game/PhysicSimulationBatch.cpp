@@ -0,0 +1,92 @@
+#include "PhysicSimulationBatch.hpp"
+
+#include <algorithm>
+
+
+PhysicSimulationBatch::PhysicSimulationBatch(size_t count, ThreadPool& pool):
+    _pool(&pool), _simulations(count), _bodies(count), _initial(count), _active(count, 1),
+    _observations(Observation_COUNT * count, 0.f), _actions(Action_COUNT * count, 0.f)
+{
+    reset();
+}
+
+void PhysicSimulationBatch::reset() {
+    auto blocks = (size() + BLOCK - 1) / BLOCK;
+
+    _pool->parallel_for(blocks, [this](size_t block, size_t) {
+        auto end = std::min(size(), (block + 1) * BLOCK);
+
+        for (size_t i = block * BLOCK; i < end; ++i)
+            reset(i);
+    });
+}
+
+void PhysicSimulationBatch::reset(size_t index) {
+    if (_simulations[index]) {
+        _simulations[index]->restore(_initial[index]);
+    }
+    else {
+        _simulations[index] = PhysicSimulation::createTestSimulation();
+        _bodies[index]      = _simulations[index]->createHumanBody({0.f, 0.f}).lock();
+        _simulations[index]->snapshot(_initial[index]);
+    }
+
+    _active[index] = 1;
+
+    for (size_t row = 0; row < Action_COUNT; ++row)
+        _actions[row * size() + index] = 0.f;
+
+    gather_observations(index);
+}
+
+void PhysicSimulationBatch::step(double delta_time) {
+    auto blocks = (size() + BLOCK - 1) / BLOCK;
+
+    _pool->parallel_for(blocks, [this, delta_time](size_t block, size_t) {
+        auto end = std::min(size(), (block + 1) * BLOCK);
+
+        for (size_t i = block * BLOCK; i < end; ++i) {
+            if (!_active[i])
+                continue;
+
+            apply_actions(i);
+            _simulations[i]->step(delta_time);
+            gather_observations(i);
+        }
+    });
+}
+
+void PhysicSimulationBatch::apply_actions(size_t index) {
+    auto& body   = *_bodies[index];
+    auto  stride = size();
+
+    for (size_t j = 0; j < JOINTS_COUNT; ++j) {
+        auto speed  = _actions[(ActionMotorSpeed  + j) * stride + index];
+        auto torque = _actions[(ActionMotorTorque + j) * stride + index];
+
+        body.enableMotor(PhysicHumanBody::BodyJoint(j), speed, torque);
+    }
+}
+
+void PhysicSimulationBatch::gather_observations(size_t index) {
+    auto& body   = *_bodies[index];
+    auto  stride = size();
+    auto  out    = [&](size_t row) -> float& { return _observations[row * stride + index]; };
+
+    for (size_t j = 0; j < JOINTS_COUNT; ++j) {
+        auto joint = PhysicHumanBody::BodyJoint(j);
+
+        out(ObservationJointAngle      + j) = body.joint_angle(joint);
+        out(ObservationJointSpeed      + j) = body.joint_speed(joint);
+        out(ObservationJointMotorSpeed + j) = body.joint_motor_speed(joint);
+    }
+
+    auto velocity = body.velocity();
+
+    out(ObservationChestAngle)    = body.part_angle();
+    out(ObservationAngularSpeed)  = body.angular_speed();
+    out(ObservationVelocityX)     = velocity.x();
+    out(ObservationVelocityY)     = velocity.y();
+    out(ObservationChestHeight)   = body.part_position(PhysicHumanBody::BodyPartChest).y();
+    out(ObservationCenterOfMassX) = body.center_of_mass().x();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "PhysicSimulation.hpp"
+#include "PhysicHumanBody.hpp"
+#include "../core/ThreadPool.hpp"
+
+/**
+ * Batch of independent simulations (ground and one human body each) stepped in lock-step
+ *
+ * Observations and actions are stored as structure of arrays: row r of the buffer holds the value r of
+ * all simulations, so observation(r)[i] is the value of simulation i. The whole observation buffer is
+ * an Observation_COUNT x size() matrix ready for batched inference.
+ *
+ * step() applies actions, steps worlds in parallel and gathers observations. Worlds share nothing,
+ * so the result doesn't depend on the threads count.
+ *
+ * Limitation: b2World::Step() of Box2D increments global profiling counters without synchronization
+ * (b2_gjkCalls, b2_toiCalls, b2_toiMaxIters, ...), so concurrent steps are a formal data race and
+ * ThreadSanitizer reports every batch step. The counters are statistics only, the solver never reads
+ * them, so simulation results are not affected, but the counters themselves are garbage.
+ */
+class PhysicSimulationBatch {
+public:
+    static constexpr size_t JOINTS_COUNT = PhysicHumanBody::BodyJoint_COUNT;
+
+    // Simulations per pool task, neighbouring columns are written by one task (less false sharing)
+    static constexpr size_t BLOCK = 16;
+
+    enum Observation : size_t {
+        ObservationJointAngle      = 0,
+        ObservationJointSpeed      = ObservationJointAngle      + JOINTS_COUNT,
+        ObservationJointMotorSpeed = ObservationJointSpeed      + JOINTS_COUNT,
+        ObservationChestAngle      = ObservationJointMotorSpeed + JOINTS_COUNT,
+        ObservationAngularSpeed,
+        ObservationVelocityX,
+        ObservationVelocityY,
+        ObservationChestHeight,
+        ObservationCenterOfMassX,
+        Observation_COUNT
+    };
+
+    enum Action : size_t {
+        ActionMotorSpeed  = 0,
+        ActionMotorTorque = ActionMotorSpeed + JOINTS_COUNT,
+        Action_COUNT      = ActionMotorTorque + JOINTS_COUNT
+    };
+
+    /**
+     * @param count - count of simulations
+     * @param pool - thread pool for stepping
+     */
+    PhysicSimulationBatch(size_t count, ThreadPool& pool);
+
+    /**
+     * Reset all simulations to the start pose, actions are reset to zero
+     */
+    void reset();
+
+    /**
+     * Reset the simulation to the start pose, its actions are reset to zero and it becomes active
+     * World is built once, later resets restore the snapshot taken after building (see PhysicSimulation::restore())
+     * @param index - index of the simulation
+     */
+    void reset(size_t index);
+
+    /**
+     * Apply actions, step all active simulations and gather their observations
+     * @param delta_time - time step
+     */
+    void step(double delta_time);
+
+    void step() { step(_step_time); }
+
+    size_t size() const {
+        return _simulations.size();
+    }
+
+    /**
+     * Inactive simulations are not stepped, their observations are kept (e.g. finished episodes)
+     */
+    void active(size_t index, bool value) {
+        _active[index] = value;
+    }
+
+    bool active(size_t index) const {
+        return _active[index];
+    }
+
+    const float* observations() const {
+        return _observations.data();
+    }
+
+    const float* observation(size_t row) const {
+        return _observations.data() + row * size();
+    }
+
+    float* actions() {
+        return _actions.data();
+    }
+
+    float* action(size_t row) {
+        return _actions.data() + row * size();
+    }
+
+    PhysicSimulation& simulation(size_t index) {
+        return *_simulations[index];
+    }
+
+    PhysicHumanBody& body(size_t index) {
+        return *_bodies[index];
+    }
+
+private:
+    void apply_actions(size_t index);
+    void gather_observations(size_t index);
+
+private:
+    ThreadPool* _pool;
+
+    std::vector<PhysicSimulation::UniquePtr>      _simulations;
+    std::vector<std::shared_ptr<PhysicHumanBody>> _bodies;
+    std::vector<PhysicSimulation::Snapshot>       _initial;
+    std::vector<uint8_t>                          _active;
+
+    std::vector<float> _observations;
+    std::vector<float> _actions;
+
+    double _step_time = 1.0 / 100.0;
+
+public:
+    DECLARE_GET_SET(step_time);
+};
@@ -0,0 +1,273 @@
+#include "PhysicThread.hpp"
+
+#include <deque>
+#include <iostream>
+#include <Box2D/Box2D.h>
+
+
+/**
+ * Debug draw backend which turns notifications of the simulation into body events and frames
+ * Works on the physics thread only
+ */
+class PhysicThread::FramePublisher : public PhysicDebugDraw, public b2QueryCallback {
+public:
+    FramePublisher(PhysicThread& thread, PhysicSimulation& simulation):
+        _thread(thread), _simulation(simulation) {}
+
+    void createObjects(b2World& world) override {
+        for (auto body = world.GetBodyList(); body; body = body->GetNext())
+            createBodyObjects(*body);
+    }
+
+    void createBodyObjects(b2Body& body) override {
+        if (_bodies.find(&body) != _bodies.end())
+            return;
+
+        auto id = _next_id++;
+        _bodies.emplace(&body, Entry{id, 0});
+
+        auto event = BodyEvent();
+        event.type      = BodyEvent::Create;
+        event.dynamic   = body.GetType() == b2_dynamicBody;
+        event.transform = transform(&body, id);
+
+        for (auto fixture = body.GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+            auto shape = Shape();
+
+            switch (fixture->GetType()) {
+                case b2Shape::e_polygon: {
+                    auto polygon = static_cast<b2PolygonShape*>(fixture->GetShape());
+
+                    shape.count = std::min(size_t(polygon->m_count), MAX_POLYGON_VERTICES);
+                    for (size_t i = 0; i < shape.count; ++i)
+                        shape.vertices[i] = {polygon->m_vertices[i].x, polygon->m_vertices[i].y};
+                } break;
+
+                case b2Shape::e_circle: {
+                    auto circle = static_cast<b2CircleShape*>(fixture->GetShape());
+
+                    shape.circle = true;
+                    shape.radius = circle->m_radius;
+                    shape.center = {circle->m_p.x, circle->m_p.y};
+                } break;
+
+                default:
+                    std::cout << "\t\tUnhandled shape" << std::endl;
+                    continue;
+            }
+
+            event.shapes.push_back(shape);
+        }
+
+        push(std::move(event));
+    }
+
+    void destroyFixtureObjects(b2Fixture& fixture) override {
+        // The body is removed with its first destroyed fixture
+        auto found = _bodies.find(fixture.GetBody());
+        if (found == _bodies.end())
+            return;
+
+        auto event = BodyEvent();
+        event.type           = BodyEvent::Destroy;
+        event.transform.body = found->second.id;
+
+        _bodies.erase(found);
+        push(std::move(event));
+    }
+
+    void update(b2World&) override {
+        ++_step;
+        _step_timestamp = timer().timestamp();
+    }
+
+    void publish() {
+        flush();
+
+        auto& frame = _thread._frames.write_buffer();
+
+        frame.step            = _step;
+        frame.simulation_time = _simulation.simulation_time();
+        frame.timestamp       = _step_timestamp;
+
+        auto& settings = frame.settings;
+        settings.on_pause           = _simulation.on_pause();
+        settings.debug_draw         = _simulation.debug_draw();
+        settings.force_update       = _simulation.force_update();
+        settings.slowdown_factor    = _simulation.slowdown_factor();
+        settings.step_time          = _simulation.step_time();
+        settings.max_catch_up_steps = _simulation.max_catch_up_steps();
+        settings.velocity_iters     = _simulation.velocity_iters();
+        settings.position_iters     = _simulation.position_iters();
+        settings.recording          = _simulation.recording();
+
+        // Percentiles are recalculated only after new steps
+        if (_simulation.simulation_time() != _profile_time || _simulation.profiler().size() != _profile.steps) {
+            _profile      = _simulation.profiler().summary();
+            _profile_time = _simulation.simulation_time();
+        }
+
+        frame.profile = _profile;
+
+        frame.bodies.clear();
+
+        if (_has_culling_rect) {
+            auto aabb = b2AABB();
+            aabb.lowerBound.Set(_culling_rect.lower.x, _culling_rect.lower.y);
+            aabb.upperBound.Set(_culling_rect.upper.x, _culling_rect.upper.y);
+
+            ++_query;
+            _simulation._world->QueryAABB(this, aabb);
+        }
+        else {
+            for (auto& [body, entry] : _bodies)
+                frame.bodies.push_back(transform(body, entry.id));
+        }
+
+        _thread._frames.publish();
+    }
+
+    void cullingRect(const Rect& rect) {
+        _culling_rect     = rect;
+        _has_culling_rect = true;
+    }
+
+    void interpolate(double) override {
+        // Readers interpolate between frames
+    }
+
+    void clear() override {
+        _bodies.clear();
+
+        auto event = BodyEvent();
+        event.type = BodyEvent::Clear;
+        push(std::move(event));
+    }
+
+    /**
+     * Adds bodies of fixtures in the culling rect to the frame being written
+     */
+    bool ReportFixture(b2Fixture* fixture) override {
+        // Bodies with several fixtures are reported several times
+        auto found = _bodies.find(fixture->GetBody());
+        if (found != _bodies.end() && found->second.query != _query) {
+            found->second.query = _query;
+            _thread._frames.write_buffer().bodies.push_back(transform(found->first, found->second.id));
+        }
+        return true;
+    }
+
+private:
+    struct Entry {
+        uint32_t id;
+        uint64_t query; // Number of the last query which found the body
+    };
+
+    static BodyTransform transform(const b2Body* body, uint32_t id) {
+        auto& position = body->GetPosition();
+        return {id, position.x, position.y, body->GetAngle()};
+    }
+
+    /**
+     * The physics thread never waits for the reader: events which don't fit the queue are kept until the next try
+     */
+    void push(BodyEvent&& event) {
+        flush();
+
+        if (!_overflow.empty() || !_thread._events.try_push(std::move(event)))
+            _overflow.push_back(std::move(event));
+    }
+
+    void flush() {
+        while (!_overflow.empty() && _thread._events.try_push(std::move(_overflow.front())))
+            _overflow.pop_front();
+    }
+
+private:
+    PhysicThread&     _thread;
+    PhysicSimulation& _simulation;
+
+    ska::flat_hash_map<const b2Body*, Entry> _bodies;
+    std::deque<BodyEvent>                    _overflow;
+
+    Rect     _culling_rect     = {};
+    bool     _has_culling_rect = false;
+    uint64_t _query            = 0;
+
+    StepProfiler::Summary _profile;
+    double                _profile_time = 0;
+
+    uint32_t  _next_id = 0;
+    uint64_t  _step    = 0;
+    Timestamp _step_timestamp;
+};
+
+
+PhysicThread::PhysicThread(PhysicSimulation::UniquePtr simulation): _simulation(std::move(simulation)) {
+    auto publisher = std::make_unique<FramePublisher>(*this, *_simulation);
+    _publisher = publisher.get();
+
+    _simulation->attachDebugDraw(std::move(publisher));
+    _simulation->debug_draw(true);
+    _publisher->publish();
+
+    _thread = std::thread(&PhysicThread::run, this);
+}
+
+PhysicThread::~PhysicThread() {
+    _stop = true;
+    _thread.join();
+
+    // Publisher refers to this object
+    _simulation->detachDebugDraw();
+}
+
+void PhysicThread::post(CommandT command) {
+    while (!_commands.try_push(std::move(command)))
+        std::this_thread::yield();
+}
+
+void PhysicThread::cullingRect(const Rect& rect) {
+    if (_has_culling_rect && rect == _culling_rect)
+        return;
+
+    _culling_rect     = rect;
+    _has_culling_rect = true;
+
+    post([publisher = _publisher, rect](PhysicSimulation&) { publisher->cullingRect(rect); });
+}
+
+void PhysicThread::run() {
+    using ClockT = std::chrono::steady_clock;
+
+    auto next_wake = ClockT::now();
+    auto command   = CommandT();
+
+    while (!_stop.load(std::memory_order_relaxed)) {
+        while (_commands.try_pop(command)) {
+            try {
+                command(*_simulation);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "PhysicThread: command failed: " << e.what() << std::endl;
+            }
+
+            command = nullptr;
+        }
+
+        _simulation->update();
+        _publisher->publish();
+
+        auto period = std::chrono::duration_cast<ClockT::duration>(
+                std::chrono::duration<double>(_simulation->step_time()));
+
+        next_wake += period;
+
+        // Don't try to catch up after long stalls (debugger, suspended process)
+        auto now = ClockT::now();
+        if (now > next_wake + period * MAX_CATCH_UP_PERIODS)
+            next_wake = now;
+
+        std::this_thread::sleep_until(next_wake);
+    }
+}
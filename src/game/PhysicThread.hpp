@@ -0,0 +1,194 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <type_traits>
+
+#include "PhysicSimulation.hpp"
+
+#include "../core/SpscQueue.hpp"
+#include "../core/TripleBuffer.hpp"
+
+
+/**
+ * PhysicSimulation running on its own thread
+ *
+ * The thread wakes every step_time() of the simulation and calls PhysicSimulation::update(), so physics
+ * rate doesn't depend on the render loop and vsync. The simulation is owned by the thread: other threads
+ * access it only with commands (post(), call()), which are applied before the next update.
+ *
+ * Results go back without locks:
+ *  - body transforms, simulation time, settings and step timings are published through a triple buffer after every
+ *    wake (frame()), the reader always gets the latest one and interpolates between the last two steps it has seen;
+ *  - geometry of created bodies, destructions and clears of the debug draw go through a SPSC event queue
+ *    (popEvent()), they are never dropped.
+ *
+ * Command side and reader side must be the same thread (e.g. the render thread).
+ */
+class PhysicThread {
+public:
+    using CommandT = std::function<void(PhysicSimulation&)>;
+
+    static constexpr size_t MAX_POLYGON_VERTICES = 8;
+    static constexpr size_t MAX_CATCH_UP_PERIODS = 4;
+
+    struct Point {
+        float x, y;
+    };
+
+    /**
+     * Axis-aligned rect in world coordinates (Box2D axes)
+     */
+    struct Rect {
+        Point lower, upper;
+
+        bool operator==(const Rect& r) const {
+            return lower.x == r.lower.x && lower.y == r.lower.y && upper.x == r.upper.x && upper.y == r.upper.y;
+        }
+
+        bool operator!=(const Rect& r) const {
+            return !(*this == r);
+        }
+    };
+
+    /**
+     * Fixture geometry in body local coordinates
+     */
+    struct Shape {
+        bool   circle = false;
+        float  radius = 0.f;
+        Point  center = {0.f, 0.f};
+        size_t count  = 0;
+        std::array<Point, MAX_POLYGON_VERTICES> vertices = {};
+    };
+
+    struct BodyTransform {
+        uint32_t body;
+        float    x, y, angle;
+    };
+
+    struct BodyEvent {
+        enum Type : uint8_t {
+            Create = 0,
+            Destroy,    // Only transform.body is set
+            Clear       // Remove all bodies created before
+        };
+
+        Type               type    = Create;
+        bool               dynamic = false;
+        BodyTransform      transform = {};
+        std::vector<Shape> shapes;
+    };
+
+    /**
+     * Settings of the simulation, changed only by commands
+     */
+    struct Settings {
+        bool     on_pause           = false;
+        bool     debug_draw         = false;
+        bool     force_update       = false;
+        double   slowdown_factor    = 1.0;
+        double   step_time          = 0.0;
+        uint32_t max_catch_up_steps = 0;
+        int32_t  velocity_iters     = 0;
+        int32_t  position_iters     = 0;
+        bool     recording          = false;
+    };
+
+    /**
+     * Published after every wake of the thread, transforms change only with the step
+     */
+    struct Frame {
+        uint64_t                   step = 0;
+        double                     simulation_time = 0;
+        Timestamp                  timestamp;        // Time of the step
+        Settings                   settings;
+        StepProfiler::Summary      profile;          // Timings of the last steps
+        std::vector<BodyTransform> bodies;           // Bodies in the culling rect, all of them without one
+    };
+
+public:
+    DECLARE_SMART_POINTERS_T(PhysicThread);
+
+    /**
+     * Start the thread, debug draw of the simulation is enabled and replaced with the frame publisher
+     * @param simulation - simulation, owned by the thread from now on
+     */
+    explicit PhysicThread(PhysicSimulation::UniquePtr simulation);
+    ~PhysicThread();
+
+    PhysicThread(const PhysicThread&) = delete;
+    PhysicThread& operator=(const PhysicThread&) = delete;
+
+    /**
+     * Apply the command on the physics thread before the next update
+     * Waits only if the command queue is full
+     */
+    void post(CommandT command);
+
+    /**
+     * Apply the function on the physics thread and wait for its result
+     * Exceptions are rethrown to the caller
+     */
+    template <typename F>
+    auto call(F&& function) -> std::invoke_result_t<F, PhysicSimulation&> {
+        using ResultT = std::invoke_result_t<F, PhysicSimulation&>;
+
+        auto task   = std::make_shared<std::packaged_task<ResultT(PhysicSimulation&)>>(std::forward<F>(function));
+        auto future = task->get_future();
+
+        post([task](PhysicSimulation& simulation) { (*task)(simulation); });
+
+        return future.get();
+    }
+
+    /**
+     * Publish only transforms of bodies which have fixtures in the rect (found by the broadphase of the world)
+     * The command is posted only if the rect has changed
+     */
+    void cullingRect(const Rect& rect);
+
+    /**
+     * Take the latest published frame
+     * @return false if there is no new frame since the last call
+     */
+    bool updateFrame() {
+        return _frames.update();
+    }
+
+    /**
+     * Frame taken by the last successful updateFrame()
+     */
+    const Frame& frame() const {
+        return _frames.read_buffer();
+    }
+
+    bool popEvent(BodyEvent& event) {
+        return _events.try_pop(event);
+    }
+
+private:
+    void run();
+
+private:
+    class FramePublisher;
+
+    PhysicSimulation::UniquePtr _simulation;
+    FramePublisher*             _publisher;
+
+    SpscQueue<CommandT>  _commands = SpscQueue<CommandT>(1024);
+    SpscQueue<BodyEvent> _events   = SpscQueue<BodyEvent>(1024);
+    TripleBuffer<Frame>  _frames;
+
+    // Command side
+    Rect _culling_rect     = {};
+    bool _has_culling_rect = false;
+
+    std::atomic<bool> _stop = false;
+    std::thread       _thread;
+};
@@ -21,7 +21,8 @@ RepeaterJointProcessor::RepeaterJointProcessor(
 }
 
 RepeaterJointProcessor::~RepeaterJointProcessor() {
-    _joint->EnableMotor(false);
+    if (!_detached)
+        _joint->EnableMotor(false);
 }
 
 void RepeaterJointProcessor::update(const PhysicBodyBase& body, double delta_time) {
@@ -14,6 +14,10 @@ public:
 
     ~RepeaterJointProcessor() final;
 
+    JointProcessor::SharedPtr clone() const final {
+        return clone_as<RepeaterJointProcessor>();
+    }
+
     void update(const class PhysicBodyBase&, double delta_time) final;
 
 private:
@@ -0,0 +1,448 @@
+#include "SimulationRecording.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <Box2D/Box2D.h>
+
+#include "../utils/ReaderWriter.hpp"
+#include "../machine_learning/details/md5.hpp"
+
+
+static void write_varint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(uint8_t(value | 0x80U));
+        value >>= 7U;
+    }
+    out.push_back(uint8_t(value));
+}
+
+static uint64_t read_varint(const std::vector<uint8_t>& in, size_t& offset) {
+    uint64_t value = 0;
+
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        if (offset >= in.size())
+            throw std::runtime_error("SimulationRecording: unexpected end of data");
+
+        auto byte = in[offset++];
+        value |= uint64_t(byte & 0x7FU) << shift;
+
+        if (!(byte & 0x80U))
+            return value;
+    }
+
+    throw std::runtime_error("SimulationRecording: invalid varint");
+}
+
+static uint32_t float_bits(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float bits_float(uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint64_t double_bits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double bits_double(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+void SimulationRecording::recordCommand(const SimulationCommand& command) {
+    _pending.push_back(command.type);
+    write_varint(_pending, command.object);
+    write_varint(_pending, command.index);
+
+    for (size_t i = 0; i < SimulationCommand::values_count[command.type]; ++i)
+        write_varint(_pending, float_bits(command.values[i]));
+
+    if (command.type == SimulationCommand::ApplyImpulse)
+        _pending.push_back(command.flag);
+
+    if (command.type == SimulationCommand::HoldAngle || command.type == SimulationCommand::SetupHuman) {
+        write_varint(_pending, command.name.size());
+        _pending.insert(_pending.end(), command.name.begin(), command.name.end());
+    }
+
+    ++_pending_count;
+}
+
+void SimulationRecording::flushPending(bool has_step) {
+    write_varint(_stream, (uint64_t(_pending_count) << 1U) | uint64_t(has_step));
+    _stream.insert(_stream.end(), _pending.begin(), _pending.end());
+
+    _pending.clear();
+    _pending_count = 0;
+}
+
+void SimulationRecording::recordStep(double delta_time, const PhysicSimulation& simulation) {
+    flushPending(true);
+
+    auto bits = double_bits(delta_time);
+    write_varint(_stream, bits ^ _prev_dt_bits);
+    _prev_dt_bits = bits;
+
+    ++_steps_count;
+
+    if (_keyframe_interval != 0 && _steps_count % _keyframe_interval == 0) {
+        simulation.snapshot(_keyframe_scratch);
+
+        auto& keyframe = _keyframes.emplace_back();
+        keyframe.step            = _steps_count;
+        keyframe.simulation_time = _keyframe_scratch.simulation_time;
+        flatten(_keyframe_scratch, keyframe.state);
+    }
+}
+
+void SimulationRecording::flatten(const PhysicSimulation::Snapshot& snapshot, std::vector<uint32_t>& dst) {
+    dst.clear();
+
+    for (auto& b : snapshot.bodies)
+        for (auto value : {b.x, b.y, b.angle, b.linear_velocity_x, b.linear_velocity_y, b.angular_velocity, float(b.awake)})
+            dst.push_back(float_bits(value));
+
+    for (auto& j : snapshot.joints)
+        for (auto value : {j.motor_speed, j.max_motor_torque, j.lower_limit, j.upper_limit,
+                           float(j.motor_enabled), float(j.limit_enabled)})
+            dst.push_back(float_bits(value));
+}
+
+void SimulationRecording::unflatten(const std::vector<uint32_t>& state, size_t bodies, size_t joints,
+                                    PhysicSimulation::Snapshot& dst) {
+    if (state.size() != bodies * 7 + joints * 6)
+        throw std::runtime_error("SimulationRecording::unflatten(): state doesn't match the world");
+
+    auto value = state.begin();
+    auto next  = [&] { return bits_float(*value++); };
+
+    dst.bodies.resize(bodies);
+    for (auto& b : dst.bodies) {
+        b.x                 = next();
+        b.y                 = next();
+        b.angle             = next();
+        b.linear_velocity_x = next();
+        b.linear_velocity_y = next();
+        b.angular_velocity  = next();
+        b.awake             = next() != 0.f;
+    }
+
+    dst.joints.resize(joints);
+    for (auto& j : dst.joints) {
+        j.motor_speed      = next();
+        j.max_motor_torque = next();
+        j.lower_limit      = next();
+        j.upper_limit      = next();
+        j.motor_enabled    = next() != 0.f;
+        j.limit_enabled    = next() != 0.f;
+    }
+}
+
+auto SimulationRecording::keyframe(uint64_t step) const -> const Keyframe* {
+    if (_keyframe_interval == 0 || step == 0 || step % _keyframe_interval != 0)
+        return nullptr;
+
+    auto index = step / _keyframe_interval - 1;
+    return index < _keyframes.size() ? &_keyframes[index] : nullptr;
+}
+
+auto SimulationRecording::last_keyframe(uint64_t step) const -> const Keyframe* {
+    auto found = std::upper_bound(_keyframes.begin(), _keyframes.end(), step, [](uint64_t step, const Keyframe& keyframe) {
+        return step < keyframe.step;
+    });
+
+    return found != _keyframes.begin() ? &*std::prev(found) : nullptr;
+}
+
+std::optional<double> SimulationRecording::Cursor::next(std::vector<SimulationCommand>& commands) {
+    auto& in = _recording->_stream;
+
+    commands.clear();
+
+    auto header = read_varint(in, _offset);
+    auto count  = header >> 1U;
+
+    for (uint64_t i = 0; i < count; ++i) {
+        auto& command = commands.emplace_back();
+
+        if (_offset >= in.size() || in[_offset] >= SimulationCommand::Type_COUNT)
+            throw std::runtime_error("SimulationRecording: invalid command");
+
+        command.type   = SimulationCommand::Type(in[_offset++]);
+        command.object = uint32_t(read_varint(in, _offset));
+        command.index  = uint32_t(read_varint(in, _offset));
+
+        for (size_t v = 0; v < SimulationCommand::values_count[command.type]; ++v)
+            command.values[v] = bits_float(uint32_t(read_varint(in, _offset)));
+
+        if (command.type == SimulationCommand::ApplyImpulse)
+            command.flag = in.at(_offset++) != 0;
+
+        if (command.type == SimulationCommand::HoldAngle || command.type == SimulationCommand::SetupHuman) {
+            auto size = read_varint(in, _offset);
+            if (_offset + size > in.size())
+                throw std::runtime_error("SimulationRecording: unexpected end of data");
+
+            command.name.assign(in.begin() + _offset, in.begin() + _offset + size);
+            _offset += size;
+        }
+    }
+
+    if (!(header & 1U))
+        return std::nullopt;
+
+    _prev_dt_bits ^= read_varint(in, _offset);
+    return bits_double(_prev_dt_bits);
+}
+
+void SimulationRecording::serialize(Writer& out) const {
+    auto data = std::vector<uint8_t>();
+
+    write_varint(data, float_bits(_settings.gravity_x));
+    write_varint(data, float_bits(_settings.gravity_y));
+    write_varint(data, uint32_t(_settings.velocity_iters));
+    write_varint(data, uint32_t(_settings.position_iters));
+    write_varint(data, _keyframe_interval);
+    write_varint(data, _steps_count);
+
+    // Commands issued after the last step become the trailing record without a step
+    auto stream = _stream;
+    if (_pending_count != 0) {
+        write_varint(stream, uint64_t(_pending_count) << 1U);
+        stream.insert(stream.end(), _pending.begin(), _pending.end());
+    }
+
+    write_varint(data, stream.size());
+    data.insert(data.end(), stream.begin(), stream.end());
+
+    write_varint(data, _keyframes.size());
+
+    const std::vector<uint32_t>* prev = nullptr;
+
+    for (auto& keyframe : _keyframes) {
+        write_varint(data, keyframe.step);
+        write_varint(data, double_bits(keyframe.simulation_time));
+        write_varint(data, keyframe.state.size());
+
+        auto same_layout = prev && prev->size() == keyframe.state.size();
+
+        for (size_t i = 0; i < keyframe.state.size(); ++i)
+            write_varint(data, keyframe.state[i] ^ (same_layout ? (*prev)[i] : 0U));
+
+        prev = &keyframe.state;
+    }
+
+    auto header = simulation_recording_header();
+    out.write(header.data(), header.size());
+
+    auto md5 = md5::md5(data.data(), data.size());
+    out.write(md5.lo);
+    out.write(md5.hi);
+
+    out.write<uint64_t>(data.size());
+    out.write(data.data(), data.size());
+}
+
+void SimulationRecording::deserialize(Reader& in) {
+    auto header = std::string(simulation_recording_header().size(), ' ');
+    in.read(header.data(), header.size());
+
+    if (header != simulation_recording_header())
+        throw std::runtime_error("SimulationRecording::deserialize(): wrong header: " + header + " vs " +
+                                 simulation_recording_header());
+
+    md5::Block128 md5;
+    in.read(md5.lo);
+    in.read(md5.hi);
+
+    auto data = std::vector<uint8_t>(in.read<uint64_t>());
+    in.read(data.data(), data.size());
+
+    if (md5 != md5::md5(data.data(), data.size()))
+        throw std::runtime_error("SimulationRecording::deserialize(): md5 checksum not valid");
+
+    size_t offset = 0;
+
+    _settings.gravity_x      = bits_float(uint32_t(read_varint(data, offset)));
+    _settings.gravity_y      = bits_float(uint32_t(read_varint(data, offset)));
+    _settings.velocity_iters = int32_t(read_varint(data, offset));
+    _settings.position_iters = int32_t(read_varint(data, offset));
+    _keyframe_interval       = read_varint(data, offset);
+    _steps_count             = read_varint(data, offset);
+
+    auto stream_size = read_varint(data, offset);
+    if (offset + stream_size > data.size())
+        throw std::runtime_error("SimulationRecording::deserialize(): unexpected end of data");
+
+    _stream.assign(data.begin() + offset, data.begin() + offset + stream_size);
+    offset += stream_size;
+
+    _pending.clear();
+    _pending_count = 0;
+    _prev_dt_bits  = 0;
+    _keyframes.resize(read_varint(data, offset));
+
+    const std::vector<uint32_t>* prev = nullptr;
+
+    for (auto& keyframe : _keyframes) {
+        keyframe.step            = read_varint(data, offset);
+        keyframe.simulation_time = bits_double(read_varint(data, offset));
+        keyframe.state.resize(read_varint(data, offset));
+
+        auto same_layout = prev && prev->size() == keyframe.state.size();
+
+        for (size_t i = 0; i < keyframe.state.size(); ++i)
+            keyframe.state[i] = uint32_t(read_varint(data, offset)) ^ (same_layout ? (*prev)[i] : 0U);
+
+        prev = &keyframe.state;
+    }
+}
+
+void SimulationRecording::save(const std::string& path) const {
+    auto file = Writer(path);
+    serialize(file);
+}
+
+void SimulationRecording::load(const std::string& path) {
+    auto file = Reader(path);
+    deserialize(file);
+}
+
+
+SimulationReplayer::SimulationReplayer(const SimulationRecording& recording, PrepareT prepare):
+    _recording(&recording), _prepare(std::move(prepare)), _cursor(recording)
+{
+    rewind();
+}
+
+void SimulationReplayer::rewind() {
+    auto& settings = _recording->settings();
+
+    _simulation = PhysicSimulation::createTestSimulation();
+    _simulation->gravity(settings.gravity_x, settings.gravity_y);
+    _simulation->velocity_iters(settings.velocity_iters);
+    _simulation->position_iters(settings.position_iters);
+
+    if (_prepare)
+        _prepare(*_simulation);
+
+    _cursor           = SimulationRecording::Cursor(*_recording);
+    _position         = 0;
+    _structure_change = 0;
+    _exact            = true;
+
+    _cache.clear();
+}
+
+void SimulationReplayer::executeCommands() {
+    for (auto& command : _commands) {
+        _simulation->execute(command);
+
+        if (command.type == SimulationCommand::SpawnBox ||
+            command.type == SimulationCommand::CreateHumanBody ||
+            command.type == SimulationCommand::DeleteBody)
+            _structure_change = _position;
+    }
+}
+
+bool SimulationReplayer::step() {
+    while (!_cursor.at_end()) {
+        auto delta_time = _cursor.next(_commands);
+        executeCommands();
+
+        if (delta_time) {
+            _simulation->step(*delta_time);
+            ++_position;
+            onKeyframe();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SimulationReplayer::restoreKeyframe(const SimulationRecording::Keyframe& keyframe) {
+    rewind();
+
+    // Commands alone rebuild objects of the keyframe's world, bodies and joints are overwritten by the keyframe
+    while (_position < keyframe.step && !_cursor.at_end()) {
+        auto delta_time = _cursor.next(_commands);
+        executeCommands();
+
+        if (delta_time)
+            ++_position;
+    }
+
+    auto snapshot = PhysicSimulation::Snapshot();
+    SimulationRecording::unflatten(keyframe.state, size_t(_simulation->_world->GetBodyCount()),
+                                   size_t(_simulation->_world->GetJointCount()), snapshot);
+    snapshot.simulation_time = keyframe.simulation_time;
+
+    _simulation->restoreWorld(snapshot);
+    _exact = false;
+}
+
+void SimulationReplayer::onKeyframe() {
+    auto recorded = _recording->keyframe(_position);
+    if (!recorded)
+        return;
+
+    // Cache is filled in step order, rewinding restarts it
+    if (_cache.empty() || _cache.back().step < _position) {
+        auto& cached = _cache.emplace_back();
+        cached.step         = _position;
+        cached.offset       = _cursor.offset();
+        cached.prev_dt_bits = _cursor.prev_dt_bits();
+        _simulation->snapshot(cached.snapshot);
+    }
+
+    if (_exact && !_divergence) {
+        PhysicSimulation::Snapshot snapshot;
+        _simulation->snapshot(snapshot);
+        SimulationRecording::flatten(snapshot, _state_scratch);
+
+        if (_state_scratch != recorded->state)
+            _divergence = _position;
+    }
+}
+
+void SimulationReplayer::seek(uint64_t step) {
+    // Stepping from the current position is cheaper than restoring keyframes before it
+    auto start = step >= _position ? _position : 0;
+
+    // Latest cached keyframe before the target without creations and deletions after it
+    auto cached = std::find_if(_cache.rbegin(), _cache.rend(), [&](const CachedKeyframe& keyframe) {
+        return keyframe.step <= step && keyframe.step > _structure_change;
+    });
+    auto cached_step = cached != _cache.rend() ? cached->step : 0;
+
+    // Cached snapshots also hold the state of objects, they are preferred at the same step
+    auto recorded = _recording->last_keyframe(step);
+
+    if (recorded && recorded->step > start && recorded->step > cached_step) {
+        restoreKeyframe(*recorded);
+    }
+    else if (cached_step > start) {
+        _simulation->restore(cached->snapshot);
+        _cursor.offset(cached->offset, cached->prev_dt_bits);
+        _position = cached->step;
+        _exact    = false;
+
+        _cache.erase(cached.base(), _cache.end());
+    }
+    else if (step < _position) {
+        rewind();
+    }
+
+    while (_position < step && this->step());
+}
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <cstdint>
+
+#include "PhysicSimulation.hpp"
+
+class Writer;
+class Reader;
+
+inline std::string simulation_recording_header() {
+    return "SIMREC-0.1";
+}
+
+
+/**
+ * Input of PhysicSimulation which is recorded and replayed
+ * Commands are applied with PhysicSimulation::execute(), creation, deletion and gravity methods
+ * of the simulation record themselves. Changes made directly through bodies are not recorded.
+ */
+struct SimulationCommand {
+    enum Type : uint8_t {
+        SpawnBox = 0,    // values: x, y, mass, velocity x, velocity y
+        CreateHumanBody, // values: x, y, height, mass
+        DeleteBody,      // object
+        SetGravity,      // values: x, y
+        ApplyImpulse,    // object, index - body part, values: impulse x, y, point x, y, flag - wake
+        EnableMotor,     // object, index - joint, values: speed, torque
+        DisableMotor,    // object, index - joint
+        Mirror,          // object
+        HoldAngle,       // object, name - HolderJointProcessor name, values: angle
+        Freeze,          // object, index - joint
+        Unfreeze,        // object, index - joint
+        SetupHuman,      // object, name - setup added by PhysicSimulation::addHumanSetup()
+        SetIterations,   // values: velocity iterations, position iterations
+        Type_COUNT
+    };
+
+    static constexpr uint8_t values_count[Type_COUNT] = {5, 4, 0, 2, 4, 2, 0, 0, 1, 0, 0, 0, 2};
+
+    Type                 type   = SpawnBox;
+    uint32_t             object = 0;
+    uint32_t             index  = 0;
+    std::array<float, 5> values = {};
+    bool                 flag   = false;
+    std::string          name;
+};
+
+
+/**
+ * Compact log of PhysicSimulation inputs with periodic state keyframes
+ *
+ * Every step is one record: commands issued since the previous step and the time step. Integers are varints,
+ * the time step is stored as XOR with the previous one, so a step with the usual fixed time step and no
+ * commands takes two bytes. Keyframes hold raw bits of body and joint states (see PhysicSimulation::Snapshot),
+ * in the file every keyframe is stored as XOR with the previous one. Commands recorded before a keyframe rebuild
+ * the objects of its world, so the keyframe together with them is enough to restore the world at its step.
+ *
+ * The recording starts from the world of PhysicSimulation::createTestSimulation() with no objects.
+ */
+class SimulationRecording {
+public:
+    struct Keyframe {
+        uint64_t              step;
+        double                simulation_time;
+        std::vector<uint32_t> state;
+    };
+
+    struct Settings {
+        float   gravity_x      = 0.f;
+        float   gravity_y      = -9.8f;
+        int32_t velocity_iters = 8;
+        int32_t position_iters = 3;
+    };
+
+    SimulationRecording() = default;
+
+    /**
+     * @param settings - world settings at the start
+     * @param keyframe_interval - steps between keyframes (0 - no keyframes)
+     */
+    SimulationRecording(const Settings& settings, size_t keyframe_interval):
+        _settings(settings), _keyframe_interval(keyframe_interval) {}
+
+    void recordCommand(const SimulationCommand& command);
+
+    /**
+     * Called by PhysicSimulation after every step
+     */
+    void recordStep(double delta_time, const PhysicSimulation& simulation);
+
+    void save(const std::string& path) const;
+    void load(const std::string& path);
+
+    void serialize(Writer& out) const;
+    void deserialize(Reader& in);
+
+    /**
+     * Raw bits of body and joint states of the snapshot, the form used by keyframes
+     */
+    static void flatten(const PhysicSimulation::Snapshot& snapshot, std::vector<uint32_t>& dst);
+
+    /**
+     * Inverse of flatten(), fills bodies and joints of the snapshot
+     * Throws std::runtime_error if the state doesn't match the counts
+     * @param bodies - count of bodies of the world
+     * @param joints - count of joints of the world
+     */
+    static void unflatten(const std::vector<uint32_t>& state, size_t bodies, size_t joints,
+                          PhysicSimulation::Snapshot& dst);
+
+    /**
+     * Reads records of the stream one by one
+     */
+    class Cursor {
+    public:
+        explicit Cursor(const SimulationRecording& recording): _recording(&recording) {}
+
+        bool at_end() const {
+            return _offset >= _recording->_stream.size();
+        }
+
+        /**
+         * Read the next record
+         * @param commands - commands issued before the step
+         * @return time step or nullopt if the record has no step (commands issued after the last step)
+         */
+        std::optional<double> next(std::vector<SimulationCommand>& commands);
+
+        size_t offset() const { return _offset; }
+        void   offset(size_t value, uint64_t prev_dt_bits) { _offset = value; _prev_dt_bits = prev_dt_bits; }
+
+        uint64_t prev_dt_bits() const { return _prev_dt_bits; }
+
+    private:
+        const SimulationRecording* _recording;
+        size_t                     _offset       = 0;
+        uint64_t                   _prev_dt_bits = 0;
+    };
+
+    const Settings& settings() const {
+        return _settings;
+    }
+
+    uint64_t steps_count() const {
+        return _steps_count;
+    }
+
+    size_t keyframe_interval() const {
+        return _keyframe_interval;
+    }
+
+    const std::vector<Keyframe>& keyframes() const {
+        return _keyframes;
+    }
+
+    /**
+     * Recorded keyframe of the step, if any
+     */
+    const Keyframe* keyframe(uint64_t step) const;
+
+    /**
+     * Latest recorded keyframe at or before the step, if any
+     */
+    const Keyframe* last_keyframe(uint64_t step) const;
+
+    /**
+     * @return size of the step stream in bytes
+     */
+    size_t stream_size() const {
+        return _stream.size() + _pending.size();
+    }
+
+private:
+    void flushPending(bool has_step);
+
+private:
+    Settings _settings;
+    size_t   _keyframe_interval = 0;
+
+    std::vector<uint8_t> _stream;
+    std::vector<uint8_t> _pending;
+    size_t               _pending_count = 0;
+    uint64_t             _prev_dt_bits  = 0;
+    uint64_t             _steps_count   = 0;
+
+    std::vector<Keyframe>      _keyframes;
+    PhysicSimulation::Snapshot _keyframe_scratch;
+};
+
+
+/**
+ * Headless replayer of SimulationRecording
+ *
+ * Replaying from the start reproduces the recorded run bit-exactly (the same build and platform), every
+ * recorded keyframe is compared with the replayed state bit by bit. Seeking restores the nearest keyframe
+ * at or before the target and steps forward from it: a snapshot cached by the replayer while passing
+ * the step, or a recorded keyframe, whose objects are rebuilt by applying the preceding commands without
+ * stepping. Box2D contact cache is not restored and recorded keyframes don't hold the state of joint
+ * processors and body update functions, so after such a seek the replay is close but not exact: exact()
+ * becomes false until the replayer is rewound to the start with seek(0).
+ */
+class SimulationReplayer {
+public:
+    using PrepareT = std::function<void(PhysicSimulation&)>;
+
+    /**
+     * @param prepare - called for every world created by the replayer before the commands,
+     *                  e.g. to add human setups used by the recording
+     */
+    explicit SimulationReplayer(const SimulationRecording& recording, PrepareT prepare = {});
+
+    /**
+     * Replay the next step
+     * @return false if there are no more steps
+     */
+    bool step();
+
+    /**
+     * Move to the state after the step count
+     * @param step - count of replayed steps
+     */
+    void seek(uint64_t step);
+
+    uint64_t position() const {
+        return _position;
+    }
+
+    bool exact() const {
+        return _exact;
+    }
+
+    /**
+     * @return first keyframe step where the replayed state differs from the recorded one
+     */
+    std::optional<uint64_t> divergence() const {
+        return _divergence;
+    }
+
+    PhysicSimulation& simulation() {
+        return *_simulation;
+    }
+
+private:
+    struct CachedKeyframe {
+        uint64_t                   step;
+        size_t                     offset;
+        uint64_t                   prev_dt_bits;
+        PhysicSimulation::Snapshot snapshot;
+    };
+
+    void rewind();
+    void executeCommands();
+    void restoreKeyframe(const SimulationRecording::Keyframe& keyframe);
+    void onKeyframe();
+
+private:
+    const SimulationRecording*   _recording;
+    PrepareT                     _prepare;
+    PhysicSimulation::UniquePtr  _simulation;
+    SimulationRecording::Cursor  _cursor;
+
+    std::vector<SimulationCommand> _commands;
+    std::vector<CachedKeyframe>    _cache;
+    std::vector<uint32_t>          _state_scratch;
+
+    uint64_t _position         = 0;
+    uint64_t _structure_change = 0; // Step after the last creation or deletion
+    bool     _exact            = true;
+
+    std::optional<uint64_t> _divergence;
+};
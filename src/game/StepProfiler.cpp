@@ -0,0 +1,59 @@
+#include "StepProfiler.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+StepProfiler::StepProfiler(size_t capacity): _profiles(capacity) {
+    if (capacity == 0)
+        throw std::logic_error("StepProfiler: capacity must be greater than zero");
+
+    _scratch.reserve(capacity);
+}
+
+void StepProfiler::push(const StepProfile& profile) {
+    _profiles[_next] = profile;
+    _next = (_next + 1) % _profiles.size();
+    _size = std::min(_size + 1, _profiles.size());
+}
+
+StepProfile StepProfiler::last() const {
+    if (_size == 0)
+        return {};
+
+    return _profiles[(_next + _profiles.size() - 1) % _profiles.size()];
+}
+
+StepProfile StepProfiler::percentile(double percent) const {
+    auto result = StepProfile();
+    if (_size == 0)
+        return result;
+
+    // Nearest rank, the whole buffer is used once it is full, so the order of steps doesn't matter
+    auto rank = size_t(std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0 * double(_size)));
+    auto nth  = rank > 0 ? rank - 1 : 0;
+
+    for (auto field : StepProfile::fields()) {
+        _scratch.clear();
+
+        for (size_t i = 0; i < _size; ++i)
+            _scratch.push_back(_profiles[i].*field);
+
+        std::nth_element(_scratch.begin(), _scratch.begin() + ptrdiff_t(nth), _scratch.end());
+        result.*field = _scratch[nth];
+    }
+
+    return result;
+}
+
+auto StepProfiler::summary() const -> Summary {
+    auto result = Summary();
+
+    result.steps  = _size;
+    result.last   = last();
+    result.median = percentile(50);
+    result.p95    = percentile(95);
+    result.max    = percentile(100);
+
+    return result;
+}
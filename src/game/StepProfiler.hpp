@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+
+/**
+ * Timings of one PhysicSimulation::step() in milliseconds
+ */
+struct StepProfile {
+    float step       = 0.f; // Whole step
+    float bodies     = 0.f; // Update functions of bodies
+    float world      = 0.f; // b2World::Step, b2Profile::step
+    float collide    = 0.f; // b2Profile::collide
+    float solve      = 0.f; // b2Profile::solve
+    float solve_toi  = 0.f; // b2Profile::solveTOI
+    float broadphase = 0.f; // b2Profile::broadphase
+    float callbacks  = 0.f; // Post update callbacks
+    float debug_draw = 0.f; // Debug draw update
+
+    static constexpr size_t FIELDS_COUNT = 9;
+
+    /**
+     * Fields in declaration order, for per-field statistics and display
+     */
+    static constexpr std::array<float StepProfile::*, FIELDS_COUNT> fields() {
+        return {&StepProfile::step, &StepProfile::bodies, &StepProfile::world, &StepProfile::collide,
+                &StepProfile::solve, &StepProfile::solve_toi, &StepProfile::broadphase,
+                &StepProfile::callbacks, &StepProfile::debug_draw};
+    }
+
+    static constexpr std::array<const char*, FIELDS_COUNT> field_names() {
+        return {"Step", "Bodies", "World", "Collide", "Solve", "Solve TOI", "Broadphase", "Callbacks", "Debug draw"};
+    }
+};
+
+
+/**
+ * Ring buffer of the last step profiles with per-field percentiles
+ */
+class StepProfiler {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 256;
+
+    struct Summary {
+        size_t      steps = 0; // Steps in the buffer
+        StepProfile last;
+        StepProfile median;
+        StepProfile p95;
+        StepProfile max;
+    };
+
+public:
+    explicit StepProfiler(size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * Add the profile, the oldest one is dropped if the buffer is full
+     */
+    void push(const StepProfile& profile);
+
+    void clear() {
+        _next = 0;
+        _size = 0;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    size_t capacity() const {
+        return _profiles.size();
+    }
+
+    /**
+     * Profile of the latest step, zeroes if there are no steps
+     */
+    StepProfile last() const;
+
+    /**
+     * Per-field percentile (nearest rank) of the stored steps, zeroes if there are no steps
+     * Fields are independent: percentile(95).step and percentile(95).solve may come from different steps
+     * @param percent - percentile in [0, 100]
+     */
+    StepProfile percentile(double percent) const;
+
+    Summary summary() const;
+
+private:
+    std::vector<StepProfile> _profiles;
+    size_t                   _next = 0;
+    size_t                   _size = 0;
+
+    mutable std::vector<float> _scratch;
+};
@@ -142,6 +142,19 @@ public:
         return {_view.getCenter().x, _view.getCenter().y};
     }
 
+    /**
+     * Axis-aligned bounds of the visible area in world coordinates (SFML axes, y is flipped against Box2D)
+     * @param view - view, rotation included
+     */
+    static sf::FloatRect view_bounds(const sf::View& view) {
+        // The view maps the visible area into [-1, 1] square
+        return view.getInverseTransform().transformRect(sf::FloatRect(-1.f, -1.f, 2.f, 2.f));
+    }
+
+    sf::FloatRect view_bounds() const {
+        return view_bounds(_view);
+    }
+
 private:
     void recalcSizeFromEyeAspect() {
         _view.setSize(_eye_width, _eye_width / _aspect_ratio);
@@ -0,0 +1,199 @@
+#include "PhysicDebugBatch.hpp"
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+#include <SFML/Graphics/RenderTarget.hpp>
+
+#include "Camera.hpp"
+
+// Unit circle, computed once for all circles
+static const auto& unitCircle() {
+    static const auto table = [] {
+        std::array<sf::Vector2f, PhysicDebugBatch::CIRCLE_SEGMENTS> points;
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            auto angle = float(M_PI * 2 * double(i) / double(points.size()));
+            points[i] = {std::cos(angle), std::sin(angle)};
+        }
+
+        return points;
+    }();
+
+    return table;
+}
+
+auto PhysicDebugBatch::find(KeyT key) -> Body* {
+    auto found = _index.find(key);
+    return found != _index.end() ? &_bodies[found->second] : nullptr;
+}
+
+void PhysicDebugBatch::addBody(KeyT key, bool dynamic) {
+    if (contains(key))
+        return;
+
+    _index.emplace(key, _bodies.size());
+
+    auto& body = _bodies.emplace_back();
+    body.key           = key;
+    body.outline_color = dynamic ? sf::Color::Green : sf::Color::Magenta;
+    body.fill_color    = body.outline_color;
+    body.fill_color.a  = 30;
+    body.visibility    = _visibility;
+
+    _dirty = true;
+}
+
+void PhysicDebugBatch::addPolygon(KeyT key, const sf::Vector2f* vertices, size_t count) {
+    auto body = find(key);
+    if (!body || count < 2)
+        return;
+
+    for (size_t i = 1; i + 1 < count; ++i) {
+        body->fill.push_back(vertices[0]);
+        body->fill.push_back(vertices[i]);
+        body->fill.push_back(vertices[i + 1]);
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        body->outline.push_back(vertices[i]);
+        body->outline.push_back(vertices[(i + 1) % count]);
+
+        body->radius = std::max(body->radius, std::hypot(vertices[i].x, vertices[i].y));
+    }
+
+    _dirty = true;
+}
+
+void PhysicDebugBatch::addCircle(KeyT key, const sf::Vector2f& center, float radius) {
+    auto body = find(key);
+    if (!body)
+        return;
+
+    auto& circle = unitCircle();
+
+    for (size_t i = 0; i < circle.size(); ++i) {
+        auto a = center + circle[i] * radius;
+        auto b = center + circle[(i + 1) % circle.size()] * radius;
+
+        body->fill.push_back(center);
+        body->fill.push_back(a);
+        body->fill.push_back(b);
+
+        body->outline.push_back(a);
+        body->outline.push_back(b);
+    }
+
+    // Radius line shows the rotation
+    body->outline.push_back(center);
+    body->outline.push_back(center + sf::Vector2f(radius, 0.f));
+
+    body->radius = std::max(body->radius, std::hypot(center.x, center.y) + radius);
+
+    _dirty = true;
+}
+
+void PhysicDebugBatch::removeBody(KeyT key) {
+    auto found = _index.find(key);
+    if (found == _index.end())
+        return;
+
+    auto index = found->second;
+    _index.erase(found);
+
+    if (index != _bodies.size() - 1) {
+        _bodies[index] = std::move(_bodies.back());
+        _index[_bodies[index].key] = index;
+    }
+
+    _bodies.pop_back();
+    _dirty = true;
+}
+
+void PhysicDebugBatch::setTransform(KeyT key, float x, float y, float angle) {
+    if (auto body = find(key)) {
+        body->x     = x;
+        body->y     = y;
+        body->angle = angle;
+
+        body->visibility = _visibility;
+
+        _dirty = true;
+    }
+}
+
+void PhysicDebugBatch::resetVisibility() {
+    ++_visibility;
+    _dirty = true;
+}
+
+void PhysicDebugBatch::clear() {
+    _bodies.clear();
+    _index.clear();
+    _dirty = true;
+}
+
+void PhysicDebugBatch::rebuild(const sf::FloatRect& bounds) const {
+    // Bounds are in SFML axes, bodies are in Box2D ones
+    auto visible = [&](const Body& body) {
+        return body.visibility == _visibility &&
+               body.x + body.radius >= bounds.left && body.x - body.radius <= bounds.left + bounds.width &&
+               -body.y + body.radius >= bounds.top && -body.y - body.radius <= bounds.top + bounds.height;
+    };
+
+    size_t fill_count    = 0;
+    size_t outline_count = 0;
+
+    for (auto& body : _bodies) {
+        if (visible(body)) {
+            fill_count    += body.fill.size();
+            outline_count += body.outline.size();
+        }
+    }
+
+    // resize() keeps the capacity, so steady state doesn't allocate
+    _fill_vertices.resize(fill_count);
+    _outline_vertices.resize(outline_count);
+
+    size_t fill_pos    = 0;
+    size_t outline_pos = 0;
+
+    for (auto& body : _bodies) {
+        if (!visible(body))
+            continue;
+
+        auto c = std::cos(body.angle);
+        auto s = std::sin(body.angle);
+
+        // Box2D y axis is flipped on the screen
+        auto transform = [&](const sf::Vector2f& p) {
+            return sf::Vector2f(body.x + p.x * c - p.y * s, -(body.y + p.x * s + p.y * c));
+        };
+
+        for (auto& p : body.fill) {
+            auto& vertex = _fill_vertices[fill_pos++];
+            vertex.position = transform(p);
+            vertex.color    = body.fill_color;
+        }
+
+        for (auto& p : body.outline) {
+            auto& vertex = _outline_vertices[outline_pos++];
+            vertex.position = transform(p);
+            vertex.color    = body.outline_color;
+        }
+    }
+
+    _bounds = bounds;
+    _dirty  = false;
+}
+
+void PhysicDebugBatch::draw(sf::RenderTarget& target, sf::RenderStates states) const {
+    // Window sets the view of the camera before its drawables are drawn
+    auto bounds = Camera::view_bounds(target.getView());
+
+    if (_dirty || bounds != _bounds)
+        rebuild(bounds);
+
+    target.draw(_fill_vertices, states);
+    target.draw(_outline_vertices, states);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <flat_hash_map.hpp>
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Drawable.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+
+/**
+ * Debug draw of physic bodies in two draw calls: one triangle array for fills and one line array for outlines
+ *
+ * Fixture geometry is tessellated once when the body is added and cached in body local coordinates (Box2D axes).
+ * Only body transforms change between frames, the arrays are rebuilt from them at most once per frame
+ * (on the first draw after a transform or view change). Outlines are 1px lines.
+ *
+ * Only visible bodies are transformed and submitted: bodies outside the view of the render target
+ * (by the bounding circle) and bodies hidden by resetVisibility() are skipped.
+ */
+class PhysicDebugBatch : public sf::Drawable {
+public:
+    using KeyT = uint64_t;
+
+    static constexpr size_t CIRCLE_SEGMENTS = 32;
+
+    /**
+     * Add a body without geometry, does nothing if the body exists
+     * @param key - unique key of the body (e.g. b2Body address or PhysicThread body id)
+     * @param dynamic - dynamic bodies are green, static and kinematic ones are magenta
+     */
+    void addBody(KeyT key, bool dynamic);
+
+    /**
+     * Add a convex polygon fixture to the body
+     * @param vertices - vertices in body local coordinates
+     */
+    void addPolygon(KeyT key, const sf::Vector2f* vertices, size_t count);
+
+    /**
+     * Add a circle fixture to the body
+     * @param center - center in body local coordinates
+     */
+    void addCircle(KeyT key, const sf::Vector2f& center, float radius);
+
+    void removeBody(KeyT key);
+
+    bool contains(KeyT key) const {
+        return _index.find(key) != _index.end();
+    }
+
+    /**
+     * Set the transform of the body, the body is visible until the next resetVisibility()
+     * @param x, y - position of the body in world coordinates (Box2D axes)
+     * @param angle - angle of the body in radians
+     */
+    void setTransform(KeyT key, float x, float y, float angle);
+
+    /**
+     * Hide all bodies until their next setTransform(), for callers which update only the bodies
+     * they know to be visible. Bodies are never hidden if it is not called
+     */
+    void resetVisibility();
+
+    void clear();
+
+    size_t size() const {
+        return _bodies.size();
+    }
+
+protected:
+    void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+private:
+    struct Body {
+        KeyT      key;
+        sf::Color fill_color;
+        sf::Color outline_color;
+        float     x = 0.f, y = 0.f, angle = 0.f;
+        float     radius = 0.f;   // Bounding circle around the body origin
+        uint64_t  visibility = 0; // Visible if equals to _visibility
+
+        std::vector<sf::Vector2f> fill;    // Triangles
+        std::vector<sf::Vector2f> outline; // Line segments
+    };
+
+    Body* find(KeyT key);
+    void  rebuild(const sf::FloatRect& bounds) const;
+
+private:
+    std::vector<Body>                 _bodies;
+    ska::flat_hash_map<KeyT, size_t>  _index;
+    uint64_t                          _visibility = 0;
+
+    mutable sf::VertexArray _fill_vertices    = sf::VertexArray(sf::Triangles);
+    mutable sf::VertexArray _outline_vertices = sf::VertexArray(sf::Lines);
+    mutable sf::FloatRect   _bounds;
+    mutable bool            _dirty            = true;
+};
@@ -0,0 +1,143 @@
+#include "SfmlPhysicDebugDraw.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <Box2D/Box2D.h>
+
+static PhysicDebugBatch::KeyT batchKey(const b2Body* body) {
+    return reinterpret_cast<uintptr_t>(body);
+}
+
+SfmlPhysicDebugDraw::SfmlPhysicDebugDraw(DrawableManagerSP drawable_manager):
+    _drawable_manager(std::move(drawable_manager))
+{
+    _batch = _drawable_manager->create<PhysicDebugBatch>();
+}
+
+SfmlPhysicDebugDraw::~SfmlPhysicDebugDraw() {
+    _drawable_manager->remove(_batch);
+}
+
+void SfmlPhysicDebugDraw::createObjects(b2World& world) {
+    for (auto body = world.GetBodyList(); body; body = body->GetNext())
+        createBodyObjects(*body);
+}
+
+void SfmlPhysicDebugDraw::createBodyObjects(b2Body& body) {
+    auto [entry, inserted] = _bodies.emplace(&body, Entry());
+    if (!inserted)
+        return;
+
+    auto key = batchKey(&body);
+    _batch->addBody(key, body.GetType() == b2_dynamicBody);
+
+    for (auto fixture = body.GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+        switch (fixture->GetType()) {
+            case b2Shape::e_polygon: {
+                auto poly = static_cast<b2PolygonShape*>(fixture->GetShape());
+
+                sf::Vector2f vertices[b2_maxPolygonVertices];
+                for (int i = 0; i < poly->m_count; ++i)
+                    vertices[i] = {poly->m_vertices[i].x, poly->m_vertices[i].y};
+
+                _batch->addPolygon(key, vertices, size_t(poly->m_count));
+            } break;
+
+            case b2Shape::e_circle: {
+                auto circle = static_cast<b2CircleShape*>(fixture->GetShape());
+                _batch->addCircle(key, {circle->m_p.x, circle->m_p.y}, circle->m_radius);
+            } break;
+
+            default:
+                std::cout << "\t\tUnhandled shape" << std::endl;
+                break;
+        }
+    }
+
+    auto& position = body.GetPosition();
+    _batch->setTransform(key, position.x, position.y, body.GetAngle());
+
+    // Interpolated from the creation transform after the next update
+    entry->second.current = {position.x, position.y, body.GetAngle()};
+    entry->second.update  = _update;
+}
+
+void SfmlPhysicDebugDraw::destroyFixtureObjects(b2Fixture& fixture) {
+    // The body is removed with its first destroyed fixture
+    auto body = fixture.GetBody();
+
+    if (_bodies.erase(body)) {
+        _batch->removeBody(batchKey(body));
+
+        auto found = std::find_if(_visible.begin(), _visible.end(), [body](auto& it) { return it.body == body; });
+        if (found != _visible.end())
+            _visible.erase(found);
+    }
+}
+
+void SfmlPhysicDebugDraw::updateBody(b2Body* body, Entry& entry) {
+    auto& position = body->GetPosition();
+    auto  current  = Transform{position.x, position.y, body->GetAngle()};
+
+    // Bodies which weren't visible on the previous update (e.g. just entered the view) are not interpolated
+    auto previous = entry.update + 1 == _update ? entry.current : current;
+
+    entry.current = current;
+    entry.update  = _update;
+
+    _visible.push_back({body, previous, current});
+    _batch->setTransform(batchKey(body), current.x, current.y, current.angle);
+}
+
+void SfmlPhysicDebugDraw::update(b2World& world) {
+    ++_update;
+    _visible.clear();
+
+    if (_camera) {
+        struct Query : b2QueryCallback {
+            explicit Query(SfmlPhysicDebugDraw& draw): self(draw) {}
+
+            bool ReportFixture(b2Fixture* fixture) override {
+                // Bodies with several fixtures are reported several times
+                auto found = self._bodies.find(fixture->GetBody());
+                if (found != self._bodies.end() && found->second.update != self._update)
+                    self.updateBody(found->first, found->second);
+                return true;
+            }
+
+            SfmlPhysicDebugDraw& self;
+        };
+
+        // View bounds are in SFML axes
+        auto bounds = _camera->view_bounds();
+        auto aabb   = b2AABB();
+        aabb.lowerBound.Set(bounds.left - CULLING_MARGIN, -(bounds.top + bounds.height) - CULLING_MARGIN);
+        aabb.upperBound.Set(bounds.left + bounds.width + CULLING_MARGIN, -bounds.top + CULLING_MARGIN);
+
+        _batch->resetVisibility();
+
+        auto query = Query(*this);
+        world.QueryAABB(&query, aabb);
+    }
+    else {
+        for (auto& [body, entry] : _bodies)
+            updateBody(body, entry);
+    }
+}
+
+void SfmlPhysicDebugDraw::interpolate(double alpha) {
+    auto t = float(alpha);
+
+    for (auto& [body, a, b] : _visible) {
+        _batch->setTransform(batchKey(body),
+                             a.x + (b.x - a.x) * t,
+                             a.y + (b.y - a.y) * t,
+                             a.angle + (b.angle - a.angle) * t);
+    }
+}
+
+void SfmlPhysicDebugDraw::clear() {
+    _bodies.clear();
+    _visible.clear();
+    _batch->clear();
+}
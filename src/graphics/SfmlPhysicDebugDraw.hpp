@@ -0,0 +1,77 @@
+#pragma once
+
+#include <flat_hash_map.hpp>
+
+#include "Camera.hpp"
+#include "DrawableManager.hpp"
+#include "PhysicDebugBatch.hpp"
+#include "../game/PhysicDebugDraw.hpp"
+#include "../core/helper_macros.hpp"
+
+class b2Body;
+class b2Fixture;
+
+/**
+ * PhysicSimulation debug draw with one PhysicDebugBatch in the DrawableManager
+ *
+ * Bodies are drawn between their transforms of the last two steps, so the picture lags the simulation
+ * by one step at most. With an attached camera only bodies in its view are updated: visible fixtures
+ * are found with the broadphase of the world (b2World::QueryAABB), other bodies are hidden.
+ */
+class SfmlPhysicDebugDraw : public PhysicDebugDraw {
+public:
+    DECLARE_SELF_FABRICS(SfmlPhysicDebugDraw);
+
+    // Bodies move between two updates, so the query area is larger than the view (meters)
+    static constexpr float CULLING_MARGIN = 1.f;
+
+    SfmlPhysicDebugDraw(DrawableManagerSP drawable_manager);
+    ~SfmlPhysicDebugDraw() override;
+
+    void attachCamera(const Camera::SharedPtr& camera) {
+        _camera = camera;
+    }
+
+    auto detachCamera() {
+        Camera::SharedPtr res = _camera;
+
+        _camera = nullptr;
+
+        return res;
+    }
+
+    void createObjects(b2World& world) override;
+    void createBodyObjects(b2Body& body) override;
+    void destroyFixtureObjects(b2Fixture& fixture) override;
+    void update(b2World& world) override;
+    void interpolate(double alpha) override;
+    void clear() override;
+
+private:
+    struct Transform {
+        float x, y, angle;
+    };
+
+    struct Entry {
+        Transform current;
+        uint64_t  update = 0; // Number of the last update() which found the body visible
+    };
+
+    struct VisibleBody {
+        b2Body*   body;
+        Transform previous;
+        Transform current;
+    };
+
+    void updateBody(b2Body* body, Entry& entry);
+
+private:
+    DrawableManagerSP _drawable_manager;
+    PhysicDebugBatch* _batch;
+
+    Camera::SharedPtr _camera;
+
+    ska::flat_hash_map<b2Body*, Entry> _bodies;
+    std::vector<VisibleBody>           _visible;
+    uint64_t                           _update = 0;
+};
@@ -0,0 +1,127 @@
+#include "SfmlPhysicThreadDraw.hpp"
+
+#include <algorithm>
+
+SfmlPhysicThreadDraw::SfmlPhysicThreadDraw(DrawableManagerSP drawable_manager):
+    _drawable_manager(std::move(drawable_manager))
+{
+    _batch = _drawable_manager->create<PhysicDebugBatch>();
+}
+
+SfmlPhysicThreadDraw::~SfmlPhysicThreadDraw() {
+    _drawable_manager->remove(_batch);
+}
+
+void SfmlPhysicThreadDraw::createEntry(const PhysicThread::BodyEvent& event) {
+    auto key = event.transform.body;
+
+    auto& entry = _entries[key];
+    entry.previous = event.transform;
+    entry.current  = event.transform;
+
+    _batch->addBody(key, event.dynamic);
+
+    for (auto& shape : event.shapes) {
+        if (shape.circle) {
+            _batch->addCircle(key, {shape.center.x, shape.center.y}, shape.radius);
+        }
+        else {
+            sf::Vector2f vertices[PhysicThread::MAX_POLYGON_VERTICES];
+            for (size_t i = 0; i < shape.count; ++i)
+                vertices[i] = {shape.vertices[i].x, shape.vertices[i].y};
+
+            _batch->addPolygon(key, vertices, shape.count);
+        }
+    }
+}
+
+void SfmlPhysicThreadDraw::removeEntry(uint32_t body) {
+    auto found = _entries.find(body);
+    if (found == _entries.end())
+        return;
+
+    _batch->removeBody(body);
+    _entries.erase(found);
+}
+
+void SfmlPhysicThreadDraw::sync(PhysicThread& thread) {
+    if (_camera) {
+        // View bounds are in SFML axes
+        auto bounds = _camera->view_bounds();
+        thread.cullingRect({
+            {bounds.left - CULLING_MARGIN, -(bounds.top + bounds.height) - CULLING_MARGIN},
+            {bounds.left + bounds.width + CULLING_MARGIN, -bounds.top + CULLING_MARGIN}
+        });
+    }
+
+    // Frame first: events pushed before it are already visible, entries created by later events
+    // are drawn since the next frame
+    auto new_frame = thread.updateFrame();
+
+    while (thread.popEvent(_event)) {
+        switch (_event.type) {
+            case PhysicThread::BodyEvent::Create:
+                createEntry(_event);
+                break;
+
+            case PhysicThread::BodyEvent::Destroy:
+                removeEntry(_event.transform.body);
+                break;
+
+            case PhysicThread::BodyEvent::Clear:
+                clear();
+                break;
+        }
+    }
+
+    auto& frame = thread.frame();
+
+    // Frames of the same step may differ by the culling rect (e.g. camera moves on pause)
+    if (new_frame) {
+        for (auto& transform : frame.bodies) {
+            auto found = _entries.find(transform.body);
+            if (found == _entries.end() || found->second.step == frame.step)
+                continue;
+
+            // Bodies which weren't in the previous frame (e.g. just entered the view) are not interpolated
+            auto& entry = found->second;
+            entry.previous = entry.step == _step ? entry.current : transform;
+            entry.current  = transform;
+            entry.step     = frame.step;
+        }
+
+        if (!_has_frame || frame.step != _step) {
+            _previous_timestamp = _has_frame ? _current_timestamp : frame.timestamp;
+            _current_timestamp  = frame.timestamp;
+            _step               = frame.step;
+            _has_frame          = true;
+        }
+    }
+
+    // Previous frame is shown at the time of the current one, so interpolation factor reaches 1 in one step
+    auto interval = (_current_timestamp - _previous_timestamp).sec();
+    auto factor   = interval > 0 ? (timer().timestamp() - _current_timestamp).sec() / interval : 1.0;
+    auto alpha    = float(std::clamp(factor, 0.0, 1.0));
+
+    // Only bodies of the frame are visible
+    _batch->resetVisibility();
+
+    for (auto& transform : frame.bodies) {
+        auto found = _entries.find(transform.body);
+        if (found == _entries.end())
+            continue;
+
+        auto& a = found->second.previous;
+        auto& b = found->second.current;
+
+        _batch->setTransform(transform.body,
+                             a.x + (b.x - a.x) * alpha,
+                             a.y + (b.y - a.y) * alpha,
+                             a.angle + (b.angle - a.angle) * alpha);
+    }
+}
+
+void SfmlPhysicThreadDraw::clear() {
+    _batch->clear();
+    _entries.clear();
+}
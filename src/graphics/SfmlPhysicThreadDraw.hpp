@@ -0,0 +1,77 @@
+#pragma once
+
+#include <limits>
+#include <flat_hash_map.hpp>
+
+#include "Camera.hpp"
+#include "DrawableManager.hpp"
+#include "PhysicDebugBatch.hpp"
+#include "../game/PhysicThread.hpp"
+#include "../core/helper_macros.hpp"
+
+/**
+ * Render thread side of PhysicThread: bodies in one PhysicDebugBatch in the DrawableManager
+ *
+ * Bodies are added and removed by body events of the thread, their transforms are interpolated
+ * between the last two frames, so the rendered state lags the physics by one step at most.
+ *
+ * With an attached camera the view of the camera is sent to the thread as the culling rect,
+ * only bodies of the latest frame (the visible ones) are drawn.
+ */
+class SfmlPhysicThreadDraw {
+public:
+    DECLARE_SELF_FABRICS(SfmlPhysicThreadDraw);
+
+    // Camera moves while the frame is on the way, so the culling rect is larger than the view (meters)
+    static constexpr float CULLING_MARGIN = 2.f;
+
+    SfmlPhysicThreadDraw(DrawableManagerSP drawable_manager);
+    ~SfmlPhysicThreadDraw();
+
+    void attachCamera(const Camera::SharedPtr& camera) {
+        _camera = camera;
+    }
+
+    auto detachCamera() {
+        Camera::SharedPtr res = _camera;
+
+        _camera = nullptr;
+
+        return res;
+    }
+
+    /**
+     * Apply new events and frames of the thread, called every render frame
+     */
+    void sync(PhysicThread& thread);
+
+    /**
+     * Remove all bodies, e.g. before switching to another thread
+     */
+    void clear();
+
+private:
+    struct Entry {
+        PhysicThread::BodyTransform previous;
+        PhysicThread::BodyTransform current;
+        uint64_t                    step = NO_STEP; // Step of the current transform
+    };
+
+    static constexpr uint64_t NO_STEP = std::numeric_limits<uint64_t>::max();
+
+    void createEntry(const PhysicThread::BodyEvent& event);
+    void removeEntry(uint32_t body);
+
+private:
+    DrawableManagerSP _drawable_manager;
+    PhysicDebugBatch* _batch;
+    Camera::SharedPtr _camera;
+
+    ska::flat_hash_map<uint32_t, Entry> _entries;
+    PhysicThread::BodyEvent             _event;
+
+    Timestamp _previous_timestamp;
+    Timestamp _current_timestamp;
+    uint64_t  _step      = 0;
+    bool      _has_frame = false;
+};
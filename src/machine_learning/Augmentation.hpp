@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+#include "details/Types.hpp"
+#include "details/Exception.hpp"
+#include "../core/Philox.hpp"
+
+namespace nnw {
+    struct AugmentationParams {
+        FloatT max_shift     = 2.f;   // Pixels
+        FloatT max_rotation  = 0.2f;  // Radians
+        FloatT elastic_alpha = 8.f;   // Displacement intensity (pixels)
+        FloatT elastic_sigma = 3.f;   // Displacement field smoothness (pixels)
+        FloatT noise         = 0.03f; // Gaussian noise standard deviation
+    };
+
+    /**
+     * On-the-fly augmentation of monochrome float images (fft::ColorMap8F layout)
+     *
+     * Applies random shift + rotation, elastic distortion and gaussian noise in one resampling pass.
+     * Every worker owns pre-allocated scratch buffers, so apply() never allocates and may run
+     * concurrently for different workers. Use transform() as DataLoader sample transform to run
+     * augmentation inside the loader worker threads.
+     */
+    class Augmentation {
+    public:
+        using TransformT = std::function<void(FloatT*, size_t, uint64_t)>;
+
+        /**
+         * @param width - image width
+         * @param height - image height
+         * @param params - augmentation parameters
+         * @param workers - max count of concurrent workers
+         */
+        Augmentation(size_t width, size_t height, const AugmentationParams& params, size_t workers):
+                _width(width), _height(height), _params(params), _scratch(workers)
+        {
+            if (!(_params.elastic_sigma > 0))
+                throw Exception("Augmentation::Augmentation(): elastic_sigma must be greater than zero");
+
+            auto size = _width * _height;
+
+            // Normalized gaussian kernel for smoothing of the elastic field
+            auto radius = static_cast<size_t>(std::ceil(_params.elastic_sigma * 3));
+            _kernel.resize(radius * 2 + 1);
+
+            for (auto& scratch : _scratch) {
+                scratch.dx .resize(size);
+                scratch.dy .resize(size);
+                scratch.tmp.resize(size);
+                scratch.out.resize(size);
+                scratch.row.resize(_width + radius * 2);
+            }
+
+            FloatT sum = 0;
+            for (size_t i = 0; i < _kernel.size(); ++i) {
+                auto x = FloatT(i) - FloatT(radius);
+                _kernel[i] = std::exp(-(x * x) / (2 * _params.elastic_sigma * _params.elastic_sigma));
+                sum += _kernel[i];
+            }
+
+            for (auto& k : _kernel)
+                k /= sum;
+        }
+
+        /**
+         * Augment image in place
+         * @param image - width * height floats
+         * @param worker - worker index, selects scratch buffers
+         * @param key - random key of the sample, same key gives same result
+         */
+        void apply(FloatT* image, size_t worker, uint64_t key) {
+            if (worker >= _scratch.size())
+                throw Exception("Augmentation::apply(): worker index out of bounds");
+
+            auto& s   = _scratch[worker];
+            auto  rng = Philox4x32(key);
+
+            elastic_field(s, rng);
+            resample(image, s, rng);
+            add_noise(image, s, rng);
+        }
+
+        auto transform() -> TransformT {
+            return [this](FloatT* image, size_t worker, uint64_t key) {
+                apply(image, worker, key);
+            };
+        }
+
+        size_t workers_count() const {
+            return _scratch.size();
+        }
+
+    private:
+        struct Scratch {
+            VectorT<FloatT> dx, dy, tmp, out, row;
+        };
+
+        // Separable blur of field, tmp and row are used as intermediate buffers
+        void blur(FloatT* __restrict field, FloatT* __restrict tmp, FloatT* __restrict row) const {
+            auto radius = static_cast<ptrdiff_t>(_kernel.size() / 2);
+            auto w      = static_cast<ptrdiff_t>(_width);
+            auto h      = static_cast<ptrdiff_t>(_height);
+
+            // Horizontal pass, row is padded with edge values, so inner loops have no bound checks
+            for (ptrdiff_t y = 0; y < h; ++y) {
+                auto src = field + y * w;
+                auto dst = tmp   + y * w;
+
+                for (ptrdiff_t x = -radius; x < w + radius; ++x)
+                    row[x + radius] = src[std::clamp(x, ptrdiff_t(0), w - 1)];
+
+                for (ptrdiff_t x = 0; x < w; ++x)
+                    dst[x] = 0;
+
+                for (ptrdiff_t k = 0; k < radius * 2 + 1; ++k) {
+                    auto kv = _kernel[k];
+
+                    for (ptrdiff_t x = 0; x < w; ++x)
+                        dst[x] += row[x + k] * kv;
+                }
+            }
+
+            // Vertical pass, rows are accumulated whole to keep inner loop contiguous
+            for (ptrdiff_t y = 0; y < h; ++y) {
+                auto dst = field + y * w;
+
+                for (ptrdiff_t x = 0; x < w; ++x)
+                    dst[x] = 0;
+
+                for (ptrdiff_t k = -radius; k <= radius; ++k) {
+                    auto src = tmp + std::clamp(y + k, ptrdiff_t(0), h - 1) * w;
+                    auto kv  = _kernel[k + radius];
+
+                    for (ptrdiff_t x = 0; x < w; ++x)
+                        dst[x] += src[x] * kv;
+                }
+            }
+        }
+
+        void elastic_field(Scratch& s, Philox4x32& rng) const {
+            auto size = _width * _height;
+
+            if (_params.elastic_alpha == 0) {
+                std::fill(s.dx.begin(), s.dx.end(), FloatT(0));
+                std::fill(s.dy.begin(), s.dy.end(), FloatT(0));
+                return;
+            }
+
+            auto uniform = std::uniform_real_distribution<FloatT>(-1, 1);
+
+            for (size_t i = 0; i < size; ++i) {
+                s.dx[i] = uniform(rng);
+                s.dy[i] = uniform(rng);
+            }
+
+            blur(s.dx.data(), s.tmp.data(), s.row.data());
+            blur(s.dy.data(), s.tmp.data(), s.row.data());
+
+            auto alpha = _params.elastic_alpha;
+            auto dx    = s.dx.data();
+            auto dy    = s.dy.data();
+
+            for (size_t i = 0; i < size; ++i) {
+                dx[i] *= alpha;
+                dy[i] *= alpha;
+            }
+        }
+
+        // Inverse mapping: out(x, y) = image(A^-1 * (x, y) + elastic(x, y)), bilinear, zero outside
+        void resample(FloatT* image, Scratch& s, Philox4x32& rng) const {
+            auto shift    = std::uniform_real_distribution<FloatT>(-_params.max_shift, _params.max_shift);
+            auto rotation = std::uniform_real_distribution<FloatT>(-_params.max_rotation, _params.max_rotation);
+
+            FloatT shift_x = _params.max_shift    > 0 ? shift(rng)    : 0;
+            FloatT shift_y = _params.max_shift    > 0 ? shift(rng)    : 0;
+            FloatT angle   = _params.max_rotation > 0 ? rotation(rng) : 0;
+
+            FloatT cs = std::cos(angle);
+            FloatT sn = std::sin(angle);
+            FloatT cx = FloatT(_width  - 1) / 2;
+            FloatT cy = FloatT(_height - 1) / 2;
+
+            auto w = static_cast<ptrdiff_t>(_width);
+            auto h = static_cast<ptrdiff_t>(_height);
+
+            auto sample = [image, w, h](ptrdiff_t x, ptrdiff_t y) {
+                return (x >= 0 && y >= 0 && x < w && y < h) ? image[y * w + x] : FloatT(0);
+            };
+
+            for (ptrdiff_t y = 0; y < h; ++y) {
+                for (ptrdiff_t x = 0; x < w; ++x) {
+                    auto   i  = y * w + x;
+                    FloatT rx = FloatT(x) - cx - shift_x;
+                    FloatT ry = FloatT(y) - cy - shift_y;
+
+                    FloatT sx = cs * rx + sn * ry + cx + s.dx[i];
+                    FloatT sy = cs * ry - sn * rx + cy + s.dy[i];
+
+                    auto   x0 = static_cast<ptrdiff_t>(std::floor(sx));
+                    auto   y0 = static_cast<ptrdiff_t>(std::floor(sy));
+                    FloatT fx = sx - FloatT(x0);
+                    FloatT fy = sy - FloatT(y0);
+
+                    FloatT top    = sample(x0, y0)     * (1 - fx) + sample(x0 + 1, y0)     * fx;
+                    FloatT bottom = sample(x0, y0 + 1) * (1 - fx) + sample(x0 + 1, y0 + 1) * fx;
+
+                    s.out[i] = top * (1 - fy) + bottom * fy;
+                }
+            }
+
+            std::memcpy(image, s.out.data(), _width * _height * sizeof(FloatT));
+        }
+
+        void add_noise(FloatT* image, Scratch& s, Philox4x32& rng) const {
+            auto size = _width * _height;
+
+            if (_params.noise > 0) {
+                auto normal = std::normal_distribution<FloatT>(0, _params.noise);
+                for (size_t i = 0; i < size; ++i)
+                    s.tmp[i] = normal(rng);
+            }
+            else {
+                std::fill(s.tmp.begin(), s.tmp.end(), FloatT(0));
+            }
+
+            auto noise = s.tmp.data();
+
+            for (size_t i = 0; i < size; ++i)
+                image[i] = std::clamp(image[i] + noise[i], FloatT(0), FloatT(1));
+        }
+
+    private:
+        size_t             _width;
+        size_t             _height;
+        AugmentationParams _params;
+
+        VectorT<FloatT>       _kernel;
+        std::vector<Scratch>  _scratch;
+    };
+}
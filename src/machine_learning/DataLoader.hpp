@@ -0,0 +1,287 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+#include <random>
+#include <numeric>
+#include <exception>
+#include <cstring>
+
+#include "details/Types.hpp"
+#include "details/Exception.hpp"
+#include "../core/Philox.hpp"
+
+namespace nnw {
+    /**
+     * Contiguous batch of samples
+     * Samples are stored row by row: sample(i) points to sample_size floats
+     */
+    struct Batch {
+        VectorT<FloatT>  data;
+        VectorT<uint8_t> labels;
+
+        size_t size        = 0;
+        size_t sample_size = 0;
+        size_t epoch       = 0;
+        size_t index       = 0; // Batch index inside the epoch
+
+        const FloatT* sample(size_t i) const {
+            return data.data() + i * sample_size;
+        }
+
+        FloatT* sample(size_t i) {
+            return data.data() + i * sample_size;
+        }
+
+        uint8_t label(size_t i) const {
+            return labels[i];
+        }
+    };
+
+    /**
+     * Shuffling data loader with background prefetch
+     *
+     * Every epoch is a new random permutation of the dataset, split into batches of fixed size
+     * (the tail which doesn't fill a whole batch is dropped). Worker threads fill a bounded ring of
+     * batches ahead of the consumer, so the training loop only swaps buffers in next().
+     * Batches are handed out in order, and the content of the batch depends only on seed, epoch and
+     * batch index, not on the workers scheduling.
+     *
+     * Optional sample transform (e.g. Augmentation::transform()) is applied to every copied sample
+     * in the worker thread: transform(sample, worker_index, sample_key). Sample key is unique for
+     * every (seed, epoch, sample position) and can be used to seed the transform. An exception of
+     * the transform stops the loader and is rethrown from next().
+     *
+     * DatasetT must provide data() (vector of maps with contiguous float data()) and labels().
+     * Dataset must outlive the loader.
+     */
+    template <typename DatasetT>
+    class DataLoader {
+    public:
+        using SampleTransformT = std::function<void(FloatT*, size_t, uint64_t)>;
+
+        /**
+         * @param dataset - source dataset
+         * @param batch_size - count of samples in one batch
+         * @param prefetch - max count of prepared batches ahead of the consumer
+         * @param workers - count of worker threads (0 - hardware concurrency / 2)
+         * @param seed - shuffling seed
+         * @param transform - sample transform, called from worker threads
+         */
+        DataLoader(const DatasetT&  dataset,
+                   size_t           batch_size,
+                   size_t           prefetch  = 8,
+                   size_t           workers   = 0,
+                   uint64_t         seed      = 0,
+                   SampleTransformT transform = {}):
+                _dataset   (dataset),
+                _batch_size(batch_size),
+                _seed      (seed),
+                _transform (std::move(transform)),
+                _slots     (prefetch)
+        {
+            if (_batch_size == 0 || prefetch == 0)
+                throw Exception("DataLoader::DataLoader(): batch size and prefetch must be > 0");
+
+            if (_dataset.data().size() < _batch_size)
+                throw Exception("DataLoader::DataLoader(): dataset is smaller than one batch");
+
+            _sample_size       = _dataset.data().front().data().size();
+            _batches_per_epoch = _dataset.data().size() / _batch_size;
+
+            if (workers == 0)
+                workers = std::max(std::thread::hardware_concurrency() / 2, 1U);
+
+            for (size_t i = 0; i < workers; ++i)
+                _workers.emplace_back(&DataLoader::worker_loop, this, i);
+        }
+
+        DataLoader(const DataLoader&) = delete;
+        DataLoader& operator=(const DataLoader&) = delete;
+
+        ~DataLoader() {
+            stop();
+        }
+
+        /**
+         * Get next batch
+         * Previous content of batch is given back to the loader for reuse, so keep one Batch object
+         * in the training loop to avoid allocations
+         * Rethrows the exception of the sample transform if a worker failed
+         * @param batch - batch to fill
+         * @return false if loader was stopped
+         */
+        bool next(Batch& batch) {
+            auto lock = std::unique_lock(_mutex);
+            auto& slot = _slots[_consumed_seq % _slots.size()];
+
+            _produced.wait(lock, [&] { return _stop || (slot.ready && slot.seq == _consumed_seq); });
+
+            if (_error)
+                std::rethrow_exception(_error);
+
+            if (_stop)
+                return false;
+
+            std::swap(batch, slot.batch);
+            slot.ready = false;
+            ++_consumed_seq;
+
+            // Previous epochs will never be requested again
+            _permutations.erase(_permutations.begin(), _permutations.lower_bound(batch.epoch));
+
+            lock.unlock();
+            _consumed.notify_all();
+
+            return true;
+        }
+
+        void stop() {
+            {
+                auto lock = std::lock_guard(_mutex);
+                _stop = true;
+            }
+
+            _produced.notify_all();
+            _consumed.notify_all();
+
+            for (auto& worker : _workers)
+                if (worker.joinable())
+                    worker.join();
+        }
+
+        size_t batch_size() const {
+            return _batch_size;
+        }
+
+        size_t sample_size() const {
+            return _sample_size;
+        }
+
+        size_t batches_per_epoch() const {
+            return _batches_per_epoch;
+        }
+
+        size_t workers_count() const {
+            return _workers.size();
+        }
+
+    private:
+        using PermutationSP = std::shared_ptr<const VectorT<uint32_t>>;
+
+        struct Slot {
+            Batch  batch;
+            size_t seq   = 0;
+            bool   ready = false;
+        };
+
+        // Must be called under lock
+        PermutationSP permutation(size_t epoch) {
+            auto found = _permutations.find(epoch);
+
+            if (found != _permutations.end())
+                return found->second;
+
+            auto perm = std::make_shared<VectorT<uint32_t>>(_dataset.data().size());
+            std::iota(perm->begin(), perm->end(), 0);
+            std::shuffle(perm->begin(), perm->end(), Philox4x32(_seed, epoch));
+
+            _permutations.emplace(epoch, perm);
+
+            return perm;
+        }
+
+        void fill(Batch& batch, size_t seq, const VectorT<uint32_t>& perm, size_t worker) {
+            batch.size        = _batch_size;
+            batch.sample_size = _sample_size;
+            batch.epoch       = seq / _batches_per_epoch;
+            batch.index       = seq % _batches_per_epoch;
+
+            batch.data  .resize(_batch_size * _sample_size);
+            batch.labels.resize(_batch_size);
+
+            auto& data   = _dataset.data();
+            auto& labels = _dataset.labels();
+
+            for (size_t i = 0; i < _batch_size; ++i) {
+                auto idx = perm[batch.index * _batch_size + i];
+
+                std::memcpy(batch.sample(i), data[idx].data().data(), _sample_size * sizeof(FloatT));
+                batch.labels[i] = labels[idx];
+
+                if (_transform)
+                    _transform(batch.sample(i), worker, Philox4x32::mix(_seed, seq * _batch_size + i));
+            }
+        }
+
+        void worker_loop(size_t worker) {
+            while (true) {
+                size_t        seq;
+                Slot*         slot;
+                PermutationSP perm;
+
+                {
+                    auto lock = std::unique_lock(_mutex);
+                    _consumed.wait(lock, [this] { return _stop || _next_seq < _consumed_seq + _slots.size(); });
+
+                    if (_stop)
+                        return;
+
+                    seq  = _next_seq++;
+                    slot = &_slots[seq % _slots.size()];
+                    perm = permutation(seq / _batches_per_epoch);
+                }
+
+                try {
+                    fill(slot->batch, seq, *perm, worker);
+                }
+                catch (...) {
+                    // Exceptions must not leave the thread, the consumer gets it from next()
+                    {
+                        auto lock = std::lock_guard(_mutex);
+                        if (!_error)
+                            _error = std::current_exception();
+                        _stop = true;
+                    }
+
+                    _produced.notify_all();
+                    _consumed.notify_all();
+                    return;
+                }
+
+                {
+                    auto lock = std::lock_guard(_mutex);
+                    slot->seq   = seq;
+                    slot->ready = true;
+                }
+
+                _produced.notify_all();
+            }
+        }
+
+    private:
+        const DatasetT& _dataset;
+
+        size_t   _batch_size;
+        size_t   _sample_size       = 0;
+        size_t   _batches_per_epoch = 0;
+        uint64_t _seed;
+
+        SampleTransformT                 _transform;
+        std::vector<Slot>                _slots;
+        std::map<size_t, PermutationSP>  _permutations;
+        std::vector<std::thread>         _workers;
+
+        size_t _next_seq     = 0;
+        size_t _consumed_seq = 0;
+        bool   _stop         = false;
+
+        std::exception_ptr _error;
+
+        std::mutex              _mutex;
+        std::condition_variable _produced;
+        std::condition_variable _consumed;
+    };
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "details/Types.hpp"
+#include "details/Exception.hpp"
+#include "FeedForwardNeuralNetwork.hpp"
+
+namespace nnw {
+    struct EvaluationResult {
+        size_t total   = 0;
+        size_t hits    = 0;
+        size_t classes = 0;
+
+        FloatT accuracy        = 0; // Percents
+        double samples_per_sec = 0;
+
+        // classes x classes, row - real label, column - network answer
+        VectorT<size_t> confusion;
+
+        size_t confusion_at(size_t real, size_t answer) const {
+            return confusion[real * classes + answer];
+        }
+    };
+
+    // Called with (evaluated samples, total samples)
+    using EvaluationProgressT = std::function<void(size_t, size_t)>;
+
+    /**
+     * Classification accuracy of the network on the whole dataset
+     *
+     * Dataset is split into chunks which are taken by threads, every thread runs single-threaded
+     * forward passes on its own copy of the network and collects its own confusion matrix.
+     * Progress callback is called from the calling thread not often than progress_interval seconds.
+     *
+     * @param network - network to evaluate, answer is the index of max output
+     * @param dataset - dataset with data() and labels() (e.g. MnistDataset)
+     * @param threads - count of threads (0 - hardware concurrency)
+     * @param progress - progress callback
+     * @param progress_interval - min interval between progress calls (seconds)
+     * @return accuracy, confusion matrix and throughput
+     */
+    template <typename DatasetT>
+    EvaluationResult evaluate(const FeedForwardNeuralNetwork& network,
+                              const DatasetT&                 dataset,
+                              size_t                          threads           = 0,
+                              const EvaluationProgressT&      progress          = {},
+                              double                          progress_interval = 0.25)
+    {
+        constexpr size_t chunk_size = 64;
+
+        auto& data   = dataset.data();
+        auto& labels = dataset.labels();
+
+        EvaluationResult result;
+        result.total   = data.size();
+        result.classes = network.output_layer_size();
+        result.confusion.resize(result.classes * result.classes, 0);
+
+        // Validate in the calling thread, worker threads must not throw
+        for (size_t i = 0; i < result.total; ++i) {
+            if (data[i].data().size() != network.input_vector_size())
+                throw Exception("nnw::evaluate(): sample size doesn't match network input layer size");
+
+            if (labels[i] >= result.classes)
+                throw Exception("nnw::evaluate(): label is out of network output range");
+        }
+
+        if (threads == 0)
+            threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+        auto start     = std::chrono::steady_clock::now();
+        auto next_idx  = std::atomic<size_t>(0);
+        auto done      = std::atomic<size_t>(0);
+        auto confusion = std::vector<VectorT<size_t>>(threads, VectorT<size_t>(result.confusion.size(), 0));
+
+        auto job = [&](size_t thread_idx) {
+            auto  context = network; // Thread-local inference context
+            auto& matrix  = confusion[thread_idx];
+
+            for (size_t begin = next_idx.fetch_add(chunk_size); begin < result.total; begin = next_idx.fetch_add(chunk_size)) {
+                auto end = std::min(begin + chunk_size, result.total);
+
+                for (size_t i = begin; i < end; ++i) {
+                    auto output = context.forward_pass<false>(data[i].data().data());
+                    auto answer = size_t(std::max_element(output.begin(), output.end()) - output.begin());
+
+                    ++matrix[labels[i] * result.classes + answer];
+                }
+
+                done.fetch_add(end - begin, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back(job, i);
+
+        if (progress) {
+            auto interval = std::chrono::duration<double>(progress_interval);
+
+            while (done.load(std::memory_order_relaxed) < result.total) {
+                progress(done.load(std::memory_order_relaxed), result.total);
+                std::this_thread::sleep_for(interval);
+            }
+        }
+
+        for (auto& th : workers)
+            th.join();
+
+        if (progress)
+            progress(result.total, result.total);
+
+        for (auto& matrix : confusion)
+            for (size_t i = 0; i < matrix.size(); ++i)
+                result.confusion[i] += matrix[i];
+
+        for (size_t i = 0; i < result.classes; ++i)
+            result.hits += result.confusion_at(i, i);
+
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        result.accuracy        = result.total ? (result.hits * FloatT(100)) / result.total : 0;
+        result.samples_per_sec = seconds > 0 ? result.total / seconds : 0;
+
+        return result;
+    }
+}
@@ -0,0 +1,287 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <stdexcept>
+
+#include "../core/ThreadPool.hpp"
+#include "../core/Philox.hpp"
+#include "WeightOperators.hpp"
+#include "Genetic.hpp"
+
+
+/**
+ * Natural evolution strategy over a flat parameter vector (OpenAI-ES, Salimans et al. 2017)
+ *
+ * Every generation samples population / 2 noise vectors eps_p and evaluates mean + sigma * eps_p and
+ * mean - sigma * eps_p (antithetic pairs). Fitness values are replaced by centered ranks, the gradient
+ * estimate sum_p (rank+_p - rank-_p) * eps_p / (population * sigma) is applied with Adam.
+ *
+ * Noise is never stored: eps_p is nnw::weight_ops::gaussian_noise() of the stream derived from
+ * (generation, p), so it is regenerated when the candidate is built and again when the gradient is
+ * accumulated. Memory doesn't depend on the population size except for one float per candidate.
+ * The gradient is accumulated in parallel by slices of parameters, not by candidates, so no reduction
+ * is needed and the result doesn't depend on the threads count.
+ *
+ * evaluate() has the same interface as Genetic<std::vector<float>>::evaluate().
+ */
+class EvolutionStrategy {
+public:
+    using FloatT      = nnw::FloatT;
+    using ParametersT = std::vector<FloatT>;
+    using ReportCallbackT = std::function<void(const GenerationReport&)>;
+
+    /**
+     * @param initial - initial mean of the search distribution
+     * @param population - count of candidates per generation, rounded up to even
+     * @param seed - seed of the noise
+     * @param stream - stream of the noise (e.g. island index)
+     */
+    EvolutionStrategy(ParametersT initial, size_t population, uint64_t seed, uint64_t stream = 0):
+        _mean(std::move(initial)), _pairs((population + 1) / 2), _seed(seed), _stream(stream)
+    {
+        if (_pairs == 0)
+            throw std::invalid_argument("EvolutionStrategy::EvolutionStrategy(): population is empty");
+
+        _fitness.resize(_pairs * 2);
+        _ranks.resize(_pairs * 2);
+        _pair_weights.resize(_pairs);
+        _gradient.resize(_mean.size());
+        _adam_m.resize(_mean.size());
+        _adam_v.resize(_mean.size());
+    }
+
+    /**
+     * Called at the end of every update(), fitness statistics describe the evaluated candidates
+     * @param callback - report consumer
+     * @param histogram_bins - count of fitness histogram bins
+     */
+    void set_report_callback(ReportCallbackT&& callback, size_t histogram_bins = 10) {
+        _report_callback = callback;
+        _histogram_bins  = histogram_bins;
+    }
+
+    size_t population() const {
+        return _pairs * 2;
+    }
+
+    size_t parameters_count() const {
+        return _mean.size();
+    }
+
+    size_t generation() const {
+        return _generation_num;
+    }
+
+    const ParametersT& mean() const {
+        return _mean;
+    }
+
+    /**
+     * Build candidate into dst: mean + sigma * eps_p for even index, mean - sigma * eps_p for odd index
+     * @param index - candidate index in [0, population())
+     * @param dst - destination, resized to parameters_count()
+     */
+    void candidate(size_t index, ParametersT& dst) const {
+        auto sign = index % 2 == 0 ? _sigma : -_sigma;
+
+        dst.assign(_mean.begin(), _mean.end());
+        nnw::weight_ops::perturb_gaussian(dst.data(), dst.size(), sign, _seed, noise_stream(index / 2));
+    }
+
+    /**
+     * Evaluate all candidates of the current generation in parallel
+     * Candidates are built in per-worker buffers, which are reused between generations
+     * @param fitness - float(ParametersT&), called concurrently for different candidates
+     * @param pool - thread pool
+     */
+    template <typename FitnessFnT>
+    void evaluate(FitnessFnT&& fitness, ThreadPool& pool) {
+        _candidates.resize(pool.size());
+
+        pool.parallel_for(population(), [&](size_t i, size_t worker) {
+            auto& params = _candidates[worker];
+            candidate(i, params);
+            _fitness[i] = fitness(params);
+        });
+    }
+
+    /**
+     * Evaluate all candidates of the current generation in parallel with per-worker contexts
+     * @param fitness - float(ParametersT&, ContextT&), called concurrently for different candidates
+     * @param contexts - contexts, one per pool worker
+     * @param pool - thread pool
+     */
+    template <typename ContextT, typename FitnessFnT>
+    void evaluate(FitnessFnT&& fitness, std::vector<ContextT>& contexts, ThreadPool& pool) {
+        if (contexts.size() < pool.size())
+            throw std::invalid_argument("EvolutionStrategy::evaluate(): contexts count < thread pool size");
+
+        _candidates.resize(pool.size());
+
+        pool.parallel_for(population(), [&](size_t i, size_t worker) {
+            auto& params = _candidates[worker];
+            candidate(i, params);
+            _fitness[i] = fitness(params, contexts[worker]);
+        });
+    }
+
+    void set_fitness(size_t index, float factor) {
+        _fitness.at(index) = factor;
+    }
+
+    /**
+     * Move the mean along the estimated gradient and start the next generation
+     * @param pool - thread pool for the gradient accumulation
+     */
+    void update(ThreadPool& pool) {
+        compute_centered_ranks();
+
+        auto scale = FloatT(1) / (FloatT(population()) * _sigma);
+        for (size_t p = 0; p < _pairs; ++p)
+            _pair_weights[p] = (_ranks[p * 2] - _ranks[p * 2 + 1]) * scale;
+
+        auto slices = (_mean.size() + SLICE - 1) / SLICE;
+
+        pool.parallel_for(slices, [&](size_t slice, size_t) {
+            auto begin = slice * SLICE;
+            auto count = std::min(SLICE, _mean.size() - begin);
+            auto grad  = _gradient.data() + begin;
+
+            std::fill(grad, grad + count, FloatT(0));
+
+            // Same noise as in candidate(): elements [begin, begin + count) of the pair stream
+            for (size_t p = 0; p < _pairs; ++p)
+                if (_pair_weights[p] != 0)
+                    nnw::weight_ops::perturb_gaussian(grad, count, _pair_weights[p], _seed, noise_stream(p), begin);
+
+            adam_step(begin, count);
+        });
+
+        if (_report_callback)
+            _report_callback(make_report());
+
+        ++_generation_num;
+    }
+
+private:
+    // Parameters per gradient task, multiple of weight_ops::CHUNK
+    static constexpr size_t SLICE = nnw::weight_ops::CHUNK * 16;
+
+    uint64_t noise_stream(size_t pair) const {
+        return Philox4x32::mix(Philox4x32::mix(_stream, _generation_num), pair);
+    }
+
+    /**
+     * Fitness shaping: ranks mapped to [-0.5, 0.5], equal fitness values get equal (average) ranks
+     */
+    void compute_centered_ranks() {
+        auto size = _fitness.size();
+
+        _order.resize(size);
+        std::iota(_order.begin(), _order.end(), size_t(0));
+        std::sort(_order.begin(), _order.end(), [this](size_t lhs, size_t rhs) {
+            return _fitness[lhs] < _fitness[rhs];
+        });
+
+        auto denominator = size > 1 ? FloatT(size - 1) : FloatT(1);
+
+        for (size_t i = 0; i < size;) {
+            auto j = i + 1;
+            while (j < size && _fitness[_order[j]] == _fitness[_order[i]])
+                ++j;
+
+            auto rank = FloatT(i + j - 1) * FloatT(0.5) / denominator - FloatT(0.5);
+            for (size_t k = i; k < j; ++k)
+                _ranks[_order[k]] = rank;
+
+            i = j;
+        }
+    }
+
+    /**
+     * Gradient ascent step with Adam for parameters [begin, begin + count), weight decay is applied to the gradient
+     */
+    void adam_step(size_t begin, size_t count) {
+        auto t      = double(_generation_num);
+        auto step   = FloatT(_learning_rate * std::sqrt(1.0 - std::pow(double(_adam_beta2), t)) /
+                                              (1.0 - std::pow(double(_adam_beta1), t)));
+        auto beta1  = _adam_beta1;
+        auto beta2  = _adam_beta2;
+        auto decay  = _weight_decay;
+
+        auto mean = _mean.data()     + begin;
+        auto grad = _gradient.data() + begin;
+        auto m    = _adam_m.data()   + begin;
+        auto v    = _adam_v.data()   + begin;
+
+        for (size_t i = 0; i < count; ++i) {
+            auto g = grad[i] - decay * mean[i];
+
+            m[i] = beta1 * m[i] + (1 - beta1) * g;
+            v[i] = beta2 * v[i] + (1 - beta2) * g * g;
+
+            mean[i] += step * m[i] / (std::sqrt(v[i]) + FloatT(1e-8));
+        }
+    }
+
+    GenerationReport make_report() const {
+        auto report = GenerationReport();
+        report.generation = _generation_num;
+
+        auto size = _fitness.size();
+
+        report.best_fitness   = _fitness[_order[size - 1]];
+        report.worst_fitness  = _fitness[_order[0]];
+        report.median_fitness = _fitness[_order[size / 2]];
+        report.mean_fitness   = float(std::accumulate(_fitness.begin(), _fitness.end(), 0.0) / double(size));
+
+        report.fitness_histogram.assign(std::max<size_t>(_histogram_bins, 1), 0);
+
+        auto range = report.best_fitness - report.worst_fitness;
+        auto bins  = report.fitness_histogram.size();
+
+        for (auto f : _fitness) {
+            size_t bin = range > 0 ? size_t((f - report.worst_fitness) / range * bins) : 0;
+            ++report.fitness_histogram[std::min(bin, bins - 1)];
+        }
+
+        return report;
+    }
+
+private:
+    ParametersT _mean;
+    ParametersT _gradient;
+    ParametersT _adam_m;
+    ParametersT _adam_v;
+
+    std::vector<ParametersT> _candidates;
+    std::vector<float>       _fitness;
+    std::vector<FloatT>      _ranks;
+    std::vector<FloatT>      _pair_weights;
+    std::vector<size_t>      _order;
+
+    ReportCallbackT _report_callback;
+    size_t          _histogram_bins = 10;
+
+    size_t   _pairs;
+    size_t   _generation_num = 1;
+    uint64_t _seed;
+    uint64_t _stream;
+
+    FloatT _sigma         = 0.02f;
+    FloatT _learning_rate = 0.01f;
+    FloatT _weight_decay  = 0.005f;
+    FloatT _adam_beta1    = 0.9f;
+    FloatT _adam_beta2    = 0.999f;
+
+public:
+    DECLARE_GET_SET(sigma);
+    DECLARE_GET_SET(learning_rate);
+    DECLARE_GET_SET(weight_decay);
+    DECLARE_GET_SET(adam_beta1);
+    DECLARE_GET_SET(adam_beta2);
+};
@@ -245,6 +245,12 @@ namespace nnw {
                 throw Exception("FeedForwardNeuralNetwork::forward_pass(): "
                                 "input vector size != input layer neurons count");
 
+            return forward_pass<_MultiThread>(input.data());
+        }
+
+        // Input must point to input layer size floats (e.g. sample of nnw::Batch)
+        template <bool _MultiThread = true>
+        auto forward_pass(const FloatT* input) -> scl::Vector<FloatT> {
             // Input
             // Note: _input_layer_size may be < _layers.front().size() because of bias neuron at the end of layer
             for (size_t i = 0; i < _input_layer_size; ++i)
@@ -615,6 +621,24 @@ namespace nnw {
                 callback(*weight);
         }
 
+        /**
+         * Copy all weights to the contiguous buffer in foreach_weight() order
+         * @param dst - buffer of weights_count() elements
+         */
+        void export_weights(FloatT* dst) const {
+            for (auto weight : _weights)
+                *dst++ = *weight;
+        }
+
+        /**
+         * Load all weights from the contiguous buffer in foreach_weight() order
+         * @param src - buffer of weights_count() elements
+         */
+        void import_weights(const FloatT* src) {
+            for (auto weight : _weights)
+                *weight = *src++;
+        }
+
         void foreach_neuron(std::function<void(Neuron&)>&& callback) {
             for (auto& layer : _layers)
                 for (auto& neuron : layer)
@@ -833,6 +857,11 @@ namespace nnw {
             return _layers.front().size();
         }
 
+        // Size of input vector (input layer without bias neurons)
+        size_t input_vector_size() const {
+            return _input_layer_size;
+        }
+
         size_t output_layer_size() const {
             return _layers.back().size();
         }
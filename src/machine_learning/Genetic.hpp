@@ -4,16 +4,83 @@
 #include <vector>
 #include <functional>
 #include <random>
+#include <ctime>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <optional>
+#include <stdexcept>
+#include <memory>
+#include <sstream>
+#include <type_traits>
 #include <scl/scl.hpp>
 
+#include "details/md5.hpp"
 #include "../core/helper_macros.hpp"
+#include "../core/time.hpp"
+#include "../core/ThreadPool.hpp"
+#include "../core/Philox.hpp"
+#include "../utils/ReaderWriter.hpp"
+#include "../utils/AsyncFileWriter.hpp"
+
+inline std::string genetic_checkpoint_header() {
+    return "GENETIC-0.2";
+}
+
+
+/**
+ * Binary (de)serialization of chromosome data for Genetic checkpoints
+ * Specialize it for custom data types
+ */
+template <typename T, typename = void>
+struct GeneticDataSerializer {
+    static_assert(sizeof(T) == 0, "GeneticDataSerializer is not specialized for this data type");
+};
+
+template <typename T>
+struct GeneticDataSerializer<T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+    static void write(Writer& w, const T& value) { w.write<T>(value); }
+    static void read(Reader& r, T& value) { value = r.read<T>(); }
+};
+
+// Contiguous containers of numbers (std::vector<float>, scl::Vector<double>, ...)
+template <typename T>
+struct GeneticDataSerializer<T, std::enable_if_t<
+        std::is_arithmetic_v<typename T::value_type> &&
+        std::is_same_v<decltype(std::declval<T&>().data()), typename T::value_type*>>>
+{
+    using ValueT = typename T::value_type;
+
+    static void write(Writer& w, const T& data) {
+        w.write<uint64_t>(data.size());
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        w.write(data.data(), data.size() * sizeof(ValueT));
+#else
+        for (auto& value : data)
+            w.write<ValueT>(value);
+#endif
+    }
+
+    static void read(Reader& r, T& data) {
+        data.resize(r.read<uint64_t>());
+
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+        r.read(data.data(), data.size() * sizeof(ValueT));
+#else
+        for (auto& value : data)
+            value = r.read<ValueT>();
+#endif
+    }
+};
+
 
 template <typename T>
 class Chromosome {
 public:
     using Type = T;
 
-    explicit Chromosome(T data): _data(data) {}
+    explicit Chromosome(const T& data): _data(data) {}
     explicit Chromosome(T&& data) noexcept: _data(std::move(data)) {}
 
     T& get() { return _data; }
@@ -29,24 +96,68 @@ private:
 };
 
 
+/**
+ * Summary of one perform_new_generation() call
+ * Fitness statistics describe the evaluated (parent) generation
+ */
+struct GenerationReport {
+    size_t generation = 0;
+
+    size_t identity_count         = 0;
+    size_t crossover_count        = 0;
+    size_t random_identity_count  = 0;
+    size_t random_crossover_count = 0;
+    size_t mutation_count         = 0;
+    bool   supermutation          = false;
+
+    float best_fitness   = 0;
+    float worst_fitness  = 0;
+    float mean_fitness   = 0;
+    float median_fitness = 0;
+
+    // Uniform bins in [worst_fitness, best_fitness]
+    std::vector<size_t> fitness_histogram;
+};
+
+
 template <typename DataType>
 class Genetic {
 public:
     using ChromosomeT = Chromosome<DataType>;
     using InitCallbackT = std::function<DataType()>;
     using CrossingOverCallbackT = std::function<DataType(ChromosomeT&, ChromosomeT&)>;
+    using CrossingOverInPlaceCallbackT = std::function<void(ChromosomeT&, ChromosomeT&, DataType&)>;
     using MutationCallbackT = std::function<void(ChromosomeT&, float)>;
-
-    Genetic(size_t generation_size): _generation_size(generation_size), _rand_gen(timer().getSystemDateTime().ms) {
+    using ReportCallbackT = std::function<void(const GenerationReport&)>;
+
+    /**
+     * Selection generator is seeded by the current time, use the seeded constructor for reproducible runs
+     */
+    Genetic(size_t generation_size):
+        Genetic(generation_size, Philox4x32::mix(uint64_t(std::time(nullptr)), timer().getSystemDateTime().ms)) {}
+
+    /**
+     * @param generation_size - count of chromosomes
+     * @param seed - seed of the selection generator
+     * @param stream - stream of the selection generator (e.g. island index)
+     */
+    Genetic(size_t generation_size, uint64_t seed, uint64_t stream = 0):
+        _generation_size(generation_size), _rand_gen(seed, stream)
+    {
         _generation.reserve(generation_size);
-        _last_generation.reserve(generation_size);
+        _next_generation.reserve(generation_size);
+        _order.reserve(generation_size);
     }
 
+    /**
+     * Create the first generation
+     * Second buffer is filled with copies, later generations only assign into existing chromosomes
+     */
     void init(InitCallbackT callback) {
         for (size_t i = 0; i < _generation_size; ++i) {
             auto data = callback();
             _generation.emplace_back(std::move(data));
-            _last_generation.emplace_back(_generation.back());
+            _next_generation.emplace_back(_generation.back());
         }
     }
 
@@ -54,10 +165,28 @@ public:
         _crossover_callback = callback;
     }
 
+    /**
+     * Crossover which writes the child into existing storage (e.g. resized vector of weights),
+     * used instead of the returning callback if set
+     */
+    void set_crossing_over_inplace_callback(CrossingOverInPlaceCallbackT&& callback) {
+        _crossover_inplace_callback = callback;
+    }
+
     void set_mutation_callback(MutationCallbackT&& callback) {
         _mutation_callback = callback;
     }
 
+    /**
+     * Called at the end of every perform_new_generation(), Genetic itself does no I/O
+     * @param callback - report consumer
+     * @param histogram_bins - count of fitness histogram bins
+     */
+    void set_report_callback(ReportCallbackT&& callback, size_t histogram_bins = 10) {
+        _report_callback = callback;
+        _histogram_bins  = histogram_bins;
+    }
+
     void init_factors(
             float identity_factor = 0.4f,
             float crossing_over_factor = 0.1f,
@@ -78,6 +207,20 @@ public:
         return _generation_size;
     }
 
+    /**
+     * Reseed the selection generator
+     */
+    void seed(uint64_t value, uint64_t stream = 0) {
+        _rand_gen = Philox4x32(value, stream);
+    }
+
+    /**
+     * Selection generator, its seed and position are saved in checkpoints
+     */
+    auto rand_gen() const -> const Philox4x32& {
+        return _rand_gen;
+    }
+
     auto begin()       { return _generation.begin(); }
     auto begin() const { return _generation.begin(); }
 
@@ -87,69 +230,276 @@ public:
     ChromosomeT& at(size_t i) { return _generation.at(i); }
     const ChromosomeT& at(size_t i) const { return _generation.at(i); }
 
+    /**
+     * Write the whole state: both generation buffers with fitness factors, generation counter,
+     * factors and the state of the random generator. Format mirrors FFNN files: header, md5, size, data.
+     */
+    void serialize(Writer& out) const {
+        auto w = Writer();
+
+        w.write<uint64_t>(_generation_size);
+        w.write<uint64_t>(_generation_num);
+
+        w.write<float>(_identity_factor);
+        w.write<float>(_crossing_over_factor);
+        w.write<float>(_random_identity_factor);
+        w.write<float>(_random_crossing_over_factor);
+        w.write<float>(_mutation_factor);
+        w.write<float>(_mutation_intensity_factor);
+        w.write<float>(_mutation_probability);
+
+        w.write<bool> (_supermutation_enabled);
+        w.write<float>(_supermutation_factor);
+        w.write<float>(_supermutation_threshold);
+
+        auto rand_state = std::ostringstream();
+        rand_state << _rand_gen;
+        auto rand_str = rand_state.str();
+
+        w.write<uint64_t>(rand_str.size());
+        w.write(rand_str.data(), rand_str.size());
+
+        w.write<bool>(_has_last_generation);
+
+        for (auto buffer : {&_generation, &_next_generation}) {
+            w.write<uint64_t>(buffer->size());
+
+            for (auto& chromosome : *buffer) {
+                w.write<float>(chromosome.fitness_factor());
+                GeneticDataSerializer<DataType>::write(w, chromosome.get());
+            }
+        }
+
+        std::vector<uint8_t> data;
+        w >> data;
+
+        auto header = genetic_checkpoint_header();
+        out.write(header.data(), header.size());
+
+        auto md5 = md5::md5(data.data(), data.size());
+        out.write(md5.lo);
+        out.write(md5.hi);
+
+        out.write<uint64_t>(data.size());
+        out.write(data.data(), data.size());
+    }
+
+    /**
+     * Restore the state written by serialize(), callbacks are not affected
+     */
+    void deserialize(Reader& in) {
+        auto header = std::string(genetic_checkpoint_header().size(), ' ');
+        in.read(header.data(), header.size());
+
+        if (header != genetic_checkpoint_header())
+            throw std::runtime_error("Genetic::deserialize(): wrong header: " + header + " vs " +
+                                     genetic_checkpoint_header());
+
+        md5::Block128 md5;
+        in.read(md5.lo);
+        in.read(md5.hi);
+
+        auto bytes = std::vector<uint8_t>(in.read<uint64_t>());
+        in.read(bytes.data(), bytes.size());
+
+        if (md5 != md5::md5(bytes.data(), bytes.size()))
+            throw std::runtime_error("Genetic::deserialize(): md5 checksum not valid");
+
+        auto r = Reader(bytes.data(), bytes.size());
+
+        _generation_size = r.read<uint64_t>();
+        _generation_num  = r.read<uint64_t>();
+
+        _identity_factor             = r.read<float>();
+        _crossing_over_factor        = r.read<float>();
+        _random_identity_factor      = r.read<float>();
+        _random_crossing_over_factor = r.read<float>();
+        _mutation_factor             = r.read<float>();
+        _mutation_intensity_factor   = r.read<float>();
+        _mutation_probability        = r.read<float>();
+
+        _supermutation_enabled   = r.read<bool>();
+        _supermutation_factor    = r.read<float>();
+        _supermutation_threshold = r.read<float>();
+
+        auto rand_str = std::string(r.read<uint64_t>(), ' ');
+        r.read(rand_str.data(), rand_str.size());
+
+        auto rand_state = std::istringstream(rand_str);
+        rand_state >> _rand_gen;
+
+        _has_last_generation = r.read<bool>();
+
+        for (auto buffer : {&_generation, &_next_generation}) {
+            auto count = r.read<uint64_t>();
+
+            if (count != _generation_size)
+                throw std::runtime_error("Genetic::deserialize(): generation size mismatch");
+
+            buffer->clear();
+            buffer->reserve(count);
+
+            for (size_t i = 0; i < count; ++i) {
+                auto& chromosome = buffer->emplace_back(DataType());
+                chromosome.fitness_factor(r.read<float>());
+                GeneticDataSerializer<DataType>::read(r, chromosome.get());
+            }
+        }
+    }
+
+    void save_checkpoint(const std::string& path) const {
+        auto file = Writer(path);
+        serialize(file);
+    }
+
+    void load_checkpoint(const std::string& path) {
+        auto file = Reader(path);
+        deserialize(file);
+    }
+
+    /**
+     * Save a checkpoint every interval generations (after breeding, so the saved generation is the one
+     * to evaluate next). The state is serialized into memory on the calling thread, the file is written
+     * by a background thread.
+     *
+     * @param path - checkpoint file path
+     * @param interval - count of generations between checkpoints (0 - disable)
+     */
+    void enable_async_checkpoints(const std::string& path, size_t interval) {
+        _checkpoint_path     = path;
+        _checkpoint_interval = interval;
+
+        if (interval != 0 && !_checkpoint_writer)
+            _checkpoint_writer = std::make_unique<AsyncFileWriter>();
+    }
+
+    /**
+     * Wait for the scheduled checkpoint to be written, rethrows the write error if any
+     */
+    void flush_checkpoints() {
+        if (_checkpoint_writer)
+            _checkpoint_writer->flush();
+    }
+
     void set_fitness(size_t index, float factor) {
         _generation.at(index).fitness_factor(factor);
     }
 
+    /**
+     * Evaluate fitness of all chromosomes of the current generation in parallel
+     * @param fitness - float(DataType&), called concurrently for different chromosomes
+     * @param pool - thread pool
+     */
+    template <typename FitnessFnT>
+    void evaluate(FitnessFnT&& fitness, ThreadPool& pool) {
+        pool.parallel_for(_generation.size(), [&](size_t i, size_t) {
+            auto& chromosome = _generation[i];
+            chromosome.fitness_factor(fitness(chromosome.get()));
+        });
+    }
 
-    struct Combination {
-        size_t a;
-        size_t b;
+    /**
+     * Evaluate fitness of all chromosomes of the current generation in parallel with per-worker contexts
+     * (e.g. private PhysicSimulation per thread). Context is never used by two threads at once.
+     * @param fitness - float(DataType&, ContextT&), called concurrently for different chromosomes
+     * @param contexts - contexts, one per pool worker
+     * @param pool - thread pool
+     */
+    template <typename ContextT, typename FitnessFnT>
+    void evaluate(FitnessFnT&& fitness, std::vector<ContextT>& contexts, ThreadPool& pool) {
+        if (contexts.size() < pool.size())
+            throw std::invalid_argument("Genetic::evaluate(): contexts count < thread pool size");
+
+        pool.parallel_for(_generation.size(), [&](size_t i, size_t worker) {
+            auto& chromosome = _generation[i];
+            chromosome.fitness_factor(fitness(chromosome.get(), contexts[worker]));
+        });
+    }
 
-        bool operator==(const Combination& c) const { return (a == c.a && b == c.b) || (a == c.b && b == c.a); }
-    };
 
-    template <typename T>
-    struct CombinationHash {
-        size_t operator()(const T& c) const {
-            return c.a * c.a + c.b * c.b;
+    /**
+     * Enumerates unordered pairs of ranks (i, j), i > j, in the triangular order:
+     * (1, 0), (2, 0), (2, 1), (3, 0), (3, 1), (3, 2), ...
+     * Every pair is produced exactly once, so no set of used combinations is needed.
+     */
+    struct PairEnumerator {
+        size_t i = 1;
+        size_t j = 0;
+
+        void next() {
+            if (++j == i) {
+                ++i;
+                j = 0;
+            }
+        }
+
+        /**
+         * @return count of ranks used by the first count pairs
+         */
+        static size_t ranks_used(size_t count) {
+            if (count == 0)
+                return 0;
+
+            size_t rows = 1;
+            while (rows * (rows + 1) / 2 < count)
+                ++rows;
+
+            return rows + 1;
         }
     };
 
+    /**
+     * Breed the next generation from the evaluated current one
+     *
+     * Generations are double-buffered: children are assigned into the chromosomes of the second
+     * buffer (reusing their storage), then buffers are swapped. Parents are selected through the
+     * sorted index order, chromosomes themselves are never moved or sorted.
+     */
     void perform_new_generation() {
-        _last_generation = _generation;
+        auto identity_max  = std::min(size_t(_generation_size * _identity_factor), _generation_size);
+        auto crossover_max = size_t(_generation_size * _crossing_over_factor);
 
-        scl::Vector<ChromosomeT> new_generation;
-        new_generation.reserve(_generation_size);
+        select_ranks(identity_max, crossover_max);
 
-        // sort by fitness factors
-        _generation.sort([](const ChromosomeT& lhs, const ChromosomeT& rhs) {
-            return lhs.fitness_factor() > rhs.fitness_factor();
-        });
+        // Only the exactly ranked prefix (see select_ranks()) may be accessed by the rank itself
+        auto sorted = [this](size_t i) -> ChromosomeT& {
+            return _generation.at(_order.at(i));
+        };
 
-        std::cout << "Identity:" << std::endl;
-        auto identity_max = size_t(_generation_size * _identity_factor);
-        for (size_t i = 0; i < identity_max; ++i) {
-            std::cout << "\t" << i << std::endl;
-            new_generation.emplace_back(_generation.at(i));
-        }
+        size_t next = 0;
 
+        GenerationReport report;
+        report.generation = _generation_num;
 
-        std::cout << "Crossover:" << std::endl;
-        size_t crossover_max = size_t(_generation_size * _crossing_over_factor);
+        auto assign = [&](ChromosomeT& src) {
+            auto& dst = _next_generation.at(next++);
+            dst.get() = src.get();
+            dst.fitness_factor(0.f);
+        };
 
+        auto crossover = [&](ChromosomeT& a, ChromosomeT& b) {
+            auto& dst = _next_generation.at(next++);
 
-        std::unordered_set<Combination, CombinationHash<Combination>> combinations;
-        for (size_t c = 0, i = 0, j = 1; c < crossover_max && i < _generation_size && j < _generation_size; ++c) {
-            std::cout << "\t" << i << " with " << j << std::endl;
-            new_generation.emplace_back(_crossover_callback(_generation.at(i), _generation.at(j)));
+            if (_crossover_inplace_callback)
+                _crossover_inplace_callback(a, b, dst.get());
+            else
+                dst.get() = _crossover_callback(a, b);
 
-            combinations.emplace(Combination{.a = i, .b = j});
+            dst.fitness_factor(0.f);
+        };
 
-            do {
-                if (i > j)
-                    ++j;
-                else if (i < j)
-                    ++i;
-                else {
-                    ++i;
-                    j = 0;
-                }
-            } while (j == i || combinations.find(Combination{.a = i, .b = j}) != combinations.end());
-        }
+        for (size_t i = 0; i < identity_max; ++i)
+            assign(sorted(i));
 
+        report.identity_count = next;
 
-        size_t reminder = _generation_size - new_generation.size();
+        auto pair = PairEnumerator();
+        for (size_t c = 0; c < crossover_max && pair.i < _generation_size && next < _generation_size; ++c, pair.next())
+            crossover(sorted(pair.j), sorted(pair.i));
+
+        report.crossover_count = next - report.identity_count;
+
+        size_t reminder = _generation_size - next;
 
         size_t rand_ident_count = static_cast<size_t>(round(
                 reminder * (_random_identity_factor / (_random_identity_factor + _random_crossing_over_factor))));
@@ -161,16 +511,18 @@ public:
         if (rand_cross_count > reminder)
             rand_cross_count = 0;
 
-        std::cout << "Random identity:" << std::endl;
+        // Ranks at the tail are partitioned but not ordered, any of them is equally good here
         for (size_t i = 0; i < rand_ident_count; ++i) {
-            auto uid = std::uniform_int_distribution<size_t>(identity_max + crossover_max, _generation_size - 1);
+            auto uid = std::uniform_int_distribution<size_t>(
+                    std::min(identity_max + crossover_max, _generation_size - 1), _generation_size - 1);
             auto rand_i = uid(_rand_gen);
 
-            std::cout << "\t" << rand_i << std::endl;
-            new_generation.emplace_back(_generation.at(rand_i));
+            assign(sorted(rand_i));
         }
 
-        std::cout << "Random crossover:" << std::endl;
+        report.random_identity_count  = rand_ident_count;
+        report.random_crossover_count = rand_cross_count;
+
         for (size_t i = 0; i < rand_cross_count; ++i) {
             auto uid = std::uniform_int_distribution<size_t>(0, _generation_size - 1);
             auto rand_i = uid(_rand_gen);
@@ -179,60 +531,58 @@ public:
             while(rand_j == rand_i)
                 rand_j = uid(_rand_gen);
 
-            std::cout << "\t" << rand_i << " with " << rand_j << std::endl;
-            new_generation.emplace_back(_crossover_callback(_generation.at(rand_i), _generation.at(rand_j)));
+            crossover(sorted(rand_i), sorted(rand_j));
         }
 
-        std::cout << "Mutation:" << std::endl;
         auto mutation_count = static_cast<size_t>(round(_mutation_factor * _generation_size));
         bool enable_mutation = std::uniform_real_distribution<float>(0, 1)(_rand_gen) < _mutation_probability;
 
         bool supermutation = false;
-        if (_supermutation_enabled) {
-            std::unordered_map<float, size_t> counter;
-            float threshold = _supermutation_threshold * _generation_size;
-
-            for (size_t i = 0; i < _generation_size; ++i) {
-                float fitness = _generation.at(i).fitness_factor();
-                auto found = counter.find(fitness);
-
-                if (found != counter.end())
-                    found->second++;
-                else
-                    counter[fitness] = 1;
-            }
-
-            for (auto& c : counter) {
-                if (c.second > threshold) {
-                    //std::cout << "Too many same chromosomes, SUPERMUTATION ENABLED" << std::endl;
-                    mutation_count = static_cast<size_t>(round(_supermutation_factor * _generation_size));
-                    supermutation = true;
-                    break;
-                }
-            }
+        if (_supermutation_enabled && has_fitness_run(_supermutation_threshold * _generation_size)) {
+            mutation_count = static_cast<size_t>(round(_supermutation_factor * _generation_size));
+            supermutation = true;
         }
 
         if (enable_mutation || supermutation) {
             mutation_count = supermutation ? mutation_count : std::uniform_int_distribution<size_t>(0, mutation_count)(_rand_gen);
-            std::cout << "MUTATION " << mutation_count << " chromosomes" << std::endl;
+
+            report.mutation_count = mutation_count;
+            report.supermutation  = supermutation;
 
             for (size_t i = 0; i < mutation_count; ++i) {
                 //auto min_i = size_t(_generation_size * _identity_factor);
                 auto uid = std::uniform_int_distribution<size_t>(1, _generation_size - 1);
                 auto rand_i = supermutation ? i : uid(_rand_gen);
-                std::cout << "\t" << rand_i << std::endl;
 
                 float intensity = supermutation ? _mutation_intensity_factor : std::uniform_real_distribution<float>(0, _mutation_intensity_factor)(_rand_gen);
-                _mutation_callback(new_generation.at(rand_i), intensity);
+                _mutation_callback(_next_generation.at(rand_i), intensity);
             }
         }
 
-        _generation = new_generation;
+        if (_report_callback) {
+            fill_fitness_stats(report);
+            _report_callback(report);
+        }
 
-        for (auto& c : _generation)
-            c.fitness_factor(0.f);
+        // Previous generation stays in the second buffer until the next call
+        std::swap(_generation, _next_generation);
+        _has_last_generation = true;
 
         ++_generation_num;
+
+        if (_checkpoint_writer && _checkpoint_interval != 0 && _generation_num % _checkpoint_interval == 0)
+            write_async_checkpoint();
+    }
+
+    /**
+     * Previous generation with its fitness factors
+     * It lives in the second buffer, so keeping it costs nothing. Valid until the next perform_new_generation()
+     */
+    auto last_generation() const -> const scl::Vector<ChromosomeT>& {
+        if (!_has_last_generation)
+            throw std::logic_error("Genetic::last_generation(): there is no previous generation yet");
+
+        return _next_generation;
     }
 
     size_t generation() const {
@@ -247,11 +597,166 @@ public:
         return _supermutation_enabled;
     }
 
+private:
+    void write_async_checkpoint() {
+        auto w = Writer();
+        serialize(w);
+
+        std::vector<uint8_t> data;
+        w >> data;
+
+        _checkpoint_writer->write(_checkpoint_path, std::move(data));
+    }
+
+    /**
+     * Partial selection instead of the full sort, O(n) + O(k log k) for the small ranked prefix
+     *
+     * After the call _order is partitioned into [0, identity_max) - the best chromosomes,
+     * [identity_max, identity_max + crossover_max) - the next best, and the rest.
+     * Ranks used by crossover pairs (and at least the best one) are exactly sorted.
+     */
+    void select_ranks(size_t identity_max, size_t crossover_max) {
+        auto size = _generation.size();
+
+        _order.resize(size);
+        std::iota(_order.begin(), _order.end(), size_t(0));
+
+        if (size == 0)
+            return;
+
+        auto better = [this](size_t lhs, size_t rhs) {
+            return _generation[lhs].fitness_factor() > _generation[rhs].fitness_factor();
+        };
+
+        auto begin    = _order.begin();
+        auto boundary = std::min(identity_max + crossover_max, size);
+        auto ranked   = std::min(std::max<size_t>(PairEnumerator::ranks_used(crossover_max), 1), size);
+
+        // Degenerate factors: crossover pairs reach beyond the partitioned part
+        if (ranked > boundary) {
+            if (ranked < size)
+                std::nth_element(begin, begin + ranked, _order.end(), better);
+
+            std::sort(begin, begin + ranked, better);
+            return;
+        }
+
+        if (boundary < size)
+            std::nth_element(begin, begin + boundary, _order.end(), better);
+
+        if (ranked <= identity_max) {
+            if (identity_max < boundary)
+                std::nth_element(begin, begin + identity_max, begin + boundary, better);
+
+            std::partial_sort(begin, begin + ranked, begin + identity_max, better);
+        }
+        else {
+            std::partial_sort(begin, begin + ranked, begin + boundary, better);
+        }
+    }
+
+    /**
+     * Detects a run of equal fitness factors longer than the threshold without counting every value
+     *
+     * In the sorted sequence such run covers at least one of the positions step, 2 * step, ...
+     * where step = floor(threshold), so only values at these positions are candidates.
+     * Candidates are found by nth_element on a scratch copy and each one is counted only in the part
+     * of the values not below the previous candidate. With more than log2(n) candidates one sort
+     * and a scan of runs is cheaper, so the cost is O(n log n) at most.
+     */
+    bool has_fitness_run(float threshold) {
+        auto size = _generation.size();
+        if (size == 0)
+            return false;
+
+        if (threshold < 1.f)
+            return true;
+
+        auto& values = _fitness_scratch;
+        values.resize(size);
+        for (size_t i = 0; i < size; ++i)
+            values[i] = _generation[i].fitness_factor();
+
+        auto step = static_cast<size_t>(threshold);
+
+        if (double(size / step) > std::log2(double(size))) {
+            std::sort(values.begin(), values.end());
+
+            size_t run = 1;
+            for (size_t i = 1; i < size; ++i) {
+                run = values[i] == values[i - 1] ? run + 1 : 1;
+
+                if (float(run) > threshold)
+                    return true;
+            }
+
+            return false;
+        }
+
+        auto previous = std::optional<float>();
+
+        for (size_t pos = step - 1; pos < size; pos += step) {
+            // Positions are increasing, so the previous partition point bounds the search range
+            auto first = values.begin() + (pos + 1 - step);
+            std::nth_element(first, values.begin() + pos, values.end());
+
+            auto candidate = values[pos];
+            if (previous == candidate)
+                continue;
+
+            previous = candidate;
+
+            // Values before first are not above the previous candidate, which is less than this one
+            if (float(std::count(first, values.end(), candidate)) > threshold)
+                return true;
+        }
+
+        return false;
+    }
+
+    void fill_fitness_stats(GenerationReport& report) {
+        auto size = _generation.size();
+        if (size == 0)
+            return;
+
+        auto& values = _fitness_scratch;
+        values.resize(size);
+        for (size_t i = 0; i < size; ++i)
+            values[i] = _generation[i].fitness_factor();
+
+        std::nth_element(values.begin(), values.begin() + size / 2, values.end(), std::greater<>());
+
+        report.best_fitness   = _generation[_order[0]].fitness_factor();
+        report.worst_fitness  = *std::min_element(values.begin(), values.end());
+        report.median_fitness = values[size / 2];
+
+        double sum = 0;
+        for (auto& c : _generation)
+            sum += c.fitness_factor();
+        report.mean_fitness = float(sum / size);
+
+        report.fitness_histogram.assign(std::max<size_t>(_histogram_bins, 1), 0);
+
+        auto range = report.best_fitness - report.worst_fitness;
+        auto bins  = report.fitness_histogram.size();
+
+        for (auto& c : _generation) {
+            size_t bin = range > 0 ? size_t((c.fitness_factor() - report.worst_fitness) / range * bins) : 0;
+            ++report.fitness_histogram[std::min(bin, bins - 1)];
+        }
+    }
+
 private:
     scl::Vector<ChromosomeT> _generation;
-    scl::Vector<ChromosomeT> _last_generation;
+    scl::Vector<ChromosomeT> _next_generation;
+    std::vector<size_t>      _order;
+    std::vector<float>       _fitness_scratch;
+    bool                     _has_last_generation = false;
 
     CrossingOverCallbackT _crossover_callback;
+    CrossingOverInPlaceCallbackT _crossover_inplace_callback;
+    ReportCallbackT _report_callback;
+    size_t _histogram_bins = 10;
     MutationCallbackT _mutation_callback;
 
     size_t _generation_num = 1;
@@ -270,7 +775,11 @@ private:
     float _supermutation_threshold = 0.4f;
 
 
-    std::mt19937 _rand_gen;
+    Philox4x32 _rand_gen;
+
+    std::string                      _checkpoint_path;
+    size_t                           _checkpoint_interval = 0;
+    std::unique_ptr<AsyncFileWriter> _checkpoint_writer;
 
 public:
     DECLARE_GET_SET(mutation_intensity_factor);
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <limits>
+
+#include "Genetic.hpp"
+#include "../core/SpscQueue.hpp"
+
+
+enum class MigrationTopology {
+    Ring,    // island i sends migrants to island i + 1
+    AllToAll // every island sends migrants to every other island
+};
+
+
+/**
+ * Throughput and migration counters of one island, accumulated over all run() calls
+ */
+struct IslandStats {
+    size_t generations = 0;
+    size_t evaluations = 0;
+    double seconds     = 0;
+
+    size_t emigrants   = 0;
+    size_t immigrants  = 0;
+    size_t dropped     = 0; // migrants not sent because the destination queue was full
+
+    float  best_fitness = -std::numeric_limits<float>::infinity();
+
+    double generations_per_sec() const { return seconds > 0 ? double(generations) / seconds : 0; }
+    double evaluations_per_sec() const { return seconds > 0 ? double(evaluations) / seconds : 0; }
+};
+
+
+/**
+ * Island model on top of Genetic
+ *
+ * Every island is an independent Genetic population evolving on its own thread. Every migration_interval
+ * generations the island sends copies of its best chromosomes to its neighbours, received migrants replace
+ * the worst chromosomes of the destination island. Migration goes through bounded lock-free SPSC queues
+ * (one per directed edge of the topology), so islands never wait for each other.
+ */
+template <typename DataType>
+class IslandGenetic {
+public:
+    using GeneticT = Genetic<DataType>;
+    using ChromosomeT = Chromosome<DataType>;
+    using InitCallbackT = std::function<DataType(size_t /* island */)>;
+    using ConfigureCallbackT = std::function<void(GeneticT&, size_t /* island */)>;
+
+    /**
+     * @param islands_count - count of islands (and threads)
+     * @param island_size - generation size of every island
+     * @param topology - migration topology
+     * @param migration_interval - generations between migrations
+     * @param migrants_count - count of best chromosomes sent to every neighbour
+     */
+    IslandGenetic(size_t            islands_count,
+                  size_t            island_size,
+                  MigrationTopology topology           = MigrationTopology::Ring,
+                  size_t            migration_interval = 10,
+                  size_t            migrants_count     = 2):
+        _migration_interval(std::max<size_t>(migration_interval, 1)),
+        _migrants_count(std::min(migrants_count, island_size))
+    {
+        if (islands_count == 0)
+            throw std::invalid_argument("IslandGenetic::IslandGenetic(): islands count must be > 0");
+
+        auto seed = Philox4x32::mix(uint64_t(std::time(nullptr)), timer().getSystemDateTime().ms);
+
+        _islands.reserve(islands_count);
+        for (size_t i = 0; i < islands_count; ++i)
+            _islands.emplace_back(std::make_unique<Island>(island_size, seed, i));
+
+        // Enough room for a few migrations if the receiver is slower
+        auto capacity = _migrants_count * 4;
+
+        auto connect = [&](size_t from, size_t to) {
+            _queues.emplace_back(std::make_unique<SpscQueue<Migrant>>(capacity));
+            _islands[from]->outgoing.push_back(_queues.back().get());
+            _islands[to]->incoming.push_back(_queues.back().get());
+        };
+
+        if (islands_count > 1 && _migrants_count > 0) {
+            if (topology == MigrationTopology::Ring) {
+                for (size_t i = 0; i < islands_count; ++i)
+                    connect(i, (i + 1) % islands_count);
+            }
+            else {
+                for (size_t i = 0; i < islands_count; ++i)
+                    for (size_t j = 0; j < islands_count; ++j)
+                        if (i != j)
+                            connect(i, j);
+            }
+        }
+    }
+
+    IslandGenetic(const IslandGenetic&) = delete;
+    IslandGenetic& operator=(const IslandGenetic&) = delete;
+
+    /**
+     * Reseed selection generators, island i gets stream i of the seed
+     */
+    void seed(uint64_t value) {
+        for (size_t i = 0; i < _islands.size(); ++i)
+            _islands[i]->genetic.seed(value, i);
+    }
+
+    /**
+     * Create the first generation of every island
+     */
+    void init(const InitCallbackT& callback) {
+        for (size_t i = 0; i < _islands.size(); ++i)
+            _islands[i]->genetic.init([&] { return callback(i); });
+    }
+
+    /**
+     * Setup callbacks and factors of every island
+     * Callbacks are called from the island thread only, so they may use per-island state (e.g. random generator)
+     */
+    void configure(const ConfigureCallbackT& callback) {
+        for (size_t i = 0; i < _islands.size(); ++i)
+            callback(_islands[i]->genetic, i);
+    }
+
+    /**
+     * Evolve all islands concurrently
+     * First exception thrown on any island stops all islands and is rethrown in the calling thread
+     *
+     * @param generations - count of generations for every island
+     * @param fitness - float(DataType&, size_t island), called concurrently for different islands
+     */
+    template <typename FitnessFnT>
+    void run(size_t generations, FitnessFnT&& fitness) {
+        std::vector<std::thread>        threads;
+        std::vector<std::exception_ptr> errors(_islands.size());
+
+        _stop = false;
+
+        threads.reserve(_islands.size());
+        for (size_t i = 0; i < _islands.size(); ++i) {
+            threads.emplace_back([&, i] {
+                try {
+                    island_loop(i, generations, fitness);
+                }
+                catch (...) {
+                    errors[i] = std::current_exception();
+                    _stop = true;
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+    }
+
+    size_t islands_count() const {
+        return _islands.size();
+    }
+
+    GeneticT& island(size_t i) {
+        return _islands.at(i)->genetic;
+    }
+
+    const IslandStats& stats(size_t i) const {
+        return _islands.at(i)->stats;
+    }
+
+    /**
+     * Best evaluated chromosome over all islands and generations
+     */
+    auto best() const -> const ChromosomeT& {
+        const Island* result = nullptr;
+
+        for (auto& island : _islands)
+            if (island->best && (!result || island->best->fitness_factor() > result->best->fitness_factor()))
+                result = island.get();
+
+        if (!result)
+            throw std::logic_error("IslandGenetic::best(): no evaluated generations yet");
+
+        return *result->best;
+    }
+
+private:
+    struct Migrant {
+        DataType data;
+        float    fitness = 0;
+    };
+
+    struct Island {
+        Island(size_t size, uint64_t seed, uint64_t stream): genetic(size, seed, stream) {}
+
+        GeneticT                         genetic;
+        std::vector<SpscQueue<Migrant>*> outgoing;
+        std::vector<SpscQueue<Migrant>*> incoming;
+        std::vector<size_t>              order;
+        std::vector<Migrant>             received;
+        std::optional<ChromosomeT>       best;
+        IslandStats                      stats;
+    };
+
+    template <typename FitnessFnT>
+    void island_loop(size_t index, size_t generations, FitnessFnT& fitness) {
+        auto& island  = *_islands[index];
+        auto& genetic = island.genetic;
+        auto  timer   = Timer();
+
+        for (size_t gen = 0; gen < generations && !_stop; ++gen) {
+            for (size_t i = 0; i < genetic.generation_size(); ++i)
+                genetic.set_fitness(i, fitness(genetic.at(i).get(), index));
+
+            island.stats.evaluations += genetic.generation_size();
+
+            update_best(island);
+            immigrate(island);
+
+            if ((island.stats.generations + 1) % _migration_interval == 0)
+                emigrate(island);
+
+            genetic.perform_new_generation();
+
+            ++island.stats.generations;
+        }
+
+        island.stats.seconds += timer.tick().sec();
+    }
+
+    void update_best(Island& island) {
+        auto& genetic = island.genetic;
+        auto  found   = std::max_element(genetic.begin(), genetic.end(), [](auto& lhs, auto& rhs) {
+            return lhs.fitness_factor() < rhs.fitness_factor();
+        });
+
+        if (found == genetic.end())
+            return;
+
+        if (!island.best || found->fitness_factor() > island.best->fitness_factor())
+            island.best = *found;
+
+        island.stats.best_fitness = island.best->fitness_factor();
+    }
+
+    // Sorts island.order by fitness, the best first
+    void sort_order(Island& island, size_t count, bool best_first) {
+        auto& genetic = island.genetic;
+
+        island.order.resize(genetic.generation_size());
+        std::iota(island.order.begin(), island.order.end(), size_t(0));
+
+        std::partial_sort(island.order.begin(), island.order.begin() + count, island.order.end(),
+                [&](size_t lhs, size_t rhs) {
+                    return best_first ? genetic.at(lhs).fitness_factor() > genetic.at(rhs).fitness_factor()
+                                      : genetic.at(lhs).fitness_factor() < genetic.at(rhs).fitness_factor();
+                });
+    }
+
+    void emigrate(Island& island) {
+        if (island.outgoing.empty())
+            return;
+
+        sort_order(island, _migrants_count, true);
+
+        for (auto queue : island.outgoing) {
+            for (size_t i = 0; i < _migrants_count; ++i) {
+                auto& chromosome = island.genetic.at(island.order[i]);
+
+                if (queue->try_push(Migrant{chromosome.get(), chromosome.fitness_factor()}))
+                    ++island.stats.emigrants;
+                else
+                    ++island.stats.dropped;
+            }
+        }
+    }
+
+    void immigrate(Island& island) {
+        auto& received = island.received;
+        received.clear();
+
+        Migrant migrant;
+        for (auto queue : island.incoming)
+            while (queue->try_pop(migrant))
+                received.push_back(std::move(migrant));
+
+        if (received.empty())
+            return;
+
+        // Only the best migrants if more arrived than fits into the population
+        auto count = std::min(received.size(), island.genetic.generation_size());
+        std::partial_sort(received.begin(), received.begin() + count, received.end(), [](auto& lhs, auto& rhs) {
+            return lhs.fitness > rhs.fitness;
+        });
+
+        sort_order(island, count, false);
+
+        for (size_t i = 0; i < count; ++i) {
+            auto& worst = island.genetic.at(island.order[i]);
+
+            if (received[i].fitness > worst.fitness_factor()) {
+                worst.get() = std::move(received[i].data);
+                worst.fitness_factor(received[i].fitness);
+                ++island.stats.immigrants;
+            }
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<Island>>             _islands;
+    std::vector<std::unique_ptr<SpscQueue<Migrant>>> _queues;
+    std::atomic<bool>                                _stop = false;
+
+    size_t _migration_interval;
+    size_t _migrants_count;
+};
@@ -6,6 +6,7 @@
 #include <zlib.h>
 
 #include "details/Exception.hpp"
+#include "../utils/IdxFile.hpp"
 
 
 namespace {
@@ -125,69 +126,54 @@ namespace {
 }
 
 nnw::MnistDataset::MnistDataset(const StringT& data_path, const StringT& labels_path) {
-    // Load data
-    {
-        auto ds = Reader(data_path);
-
-        if (has_postfix(data_path, ".gz")) {
-            auto decompressed = gz_decompress(ds.read<StringT>(ds.size()), create_decompress_callback(data_path));
-            ds = Reader(decompressed.data(), decompressed.size());
+    auto open_idx = [](const StringT& path) {
+        if (has_postfix(path, ".gz")) {
+            auto ds = Reader(path);
+            return IdxFile::from_memory(gz_decompress(ds.read<StringT>(ds.size()), create_decompress_callback(path)));
         }
 
-        if (ds.read<uint32_t>() != 0x03080000)
-            throw Exception("MnistDataset::MnistDataset(): Wrong magic number!");
-
-        size_t size = byte_swap(ds.read<uint32_t>());
-        _data.reserve(size);
-        _width  = byte_swap(ds.read<uint32_t>());
-        _height = byte_swap(ds.read<uint32_t>());
+        return IdxFile(path);
+    };
 
-        for (size_t i = 0; i < size; ++i) {
-            auto map = fft::ColorMap8F(_width, _height);
+    auto data_file  = open_idx(data_path);
+    auto label_file = open_idx(labels_path);
 
-            for (size_t j = 0; j < _height; ++j)
-                for (size_t k = 0; k < _width; ++k)
-                    map[j][k] = ds.read<uint8_t>() / 255.f;
+    if (!data_file.dtype_is<uint8_t>() || data_file.rank() != 3)
+        throw Exception("MnistDataset::MnistDataset(): data must be 3-dimensional uint8 tensor!");
 
-            _data.push_back(std::move(map));
-        }
-    }
+    if (!label_file.dtype_is<uint8_t>() || label_file.rank() != 1)
+        throw Exception("MnistDataset::MnistDataset(): labels must be 1-dimensional uint8 tensor!");
 
-    // Load labels
-    {
-        auto ds = Reader(labels_path);
+    if (label_file.count() != data_file.count())
+        throw Exception("MnistDataset::MnistDataset(): Labels count != images count");
 
-        if (has_postfix(labels_path, ".gz")) {
-            auto decompressed = gz_decompress(ds.read<StringT>(ds.size()), create_decompress_callback(data_path));
-            ds = Reader(decompressed.data(), decompressed.size());
-        }
+    auto images = data_file.view<uint8_t>();
+    auto labels = label_file.view<uint8_t>();
 
-        if (ds.read<uint32_t>() != 0x01080000)
-            throw Exception("MnistDataset::MnistDataset(): Wrong magic number!");
+    _height = images.dim(1);
+    _width  = images.dim(2);
 
-        if (byte_swap(ds.read<uint32_t>()) != _data.size())
-            throw Exception("MnistDataset::MnistDataset(): Labels count != images count");
-
-        _labels.reserve(_data.size());
-
-        for (size_t i = 0; i < _data.size(); ++i)
-            _labels.push_back(ds.read<uint8_t>());
+    _data.reserve(images.dim(0));
+    for (size_t i = 0; i < images.dim(0); ++i) {
+        auto map = fft::ColorMap8F(_width, _height);
+        images[i].copy_to(map.data().data(), 1.f / 255.f);
+        _data.push_back(std::move(map));
     }
+
+    _labels.resize(labels.dim(0));
+    labels.copy_to(_labels.data());
 }
 
-void nnw::MnistDataset::save_tga(const StringT& dir, size_t count) const {
+void nnw::MnistDataset::save_tga(const StringT& dir, size_t count, bool rle) const {
     scm::fs::create_dir(dir);
 
-    for (size_t i = 0; i < count; ++i) {
-        StringT name = StringT("digit-") + std::to_string(i) + ".tga";
+    count = std::min(count, _data.size());
 
-        auto image = fft::TruevisionImage(fft::TruevisionImage::Type::Monochrome);
+    fft::TruevisionImage::save_parallel(count, [&](size_t i, fft::TruevisionImage& image) {
         image.from_color_map(_data[i]);
-        image.save(dir + name);
+        return dir + "digit-" + std::to_string(i) + ".tga";
+    }, rle);
 
-        if (i > count)
-            break;
-    }
     auto sr = Writer();
 
     sr.write(StringT("labels:\n"));
@@ -19,11 +19,17 @@ namespace nnw {
             return _labels;
         }
 
-        size_t count() {
+        size_t count() const {
             return _data.size();
         }
 
-        void save_tga(const StringT& dir, size_t count = 100) const;
+        /**
+         * Export first count images as TGA files in parallel
+         * @param dir - output directory (with trailing slash)
+         * @param count - count of images
+         * @param rle - use RLE compression
+         */
+        void save_tga(const StringT& dir, size_t count = 100, bool rle = true) const;
 
     public:
         template <typename T>
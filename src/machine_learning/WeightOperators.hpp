@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+#include "details/Types.hpp"
+#include "../core/Philox.hpp"
+
+namespace nnw {
+    /**
+     * Bulk genetic operators over contiguous weight buffers (see FeedForwardNeuralNetwork::export_weights())
+     *
+     * Random numbers are Philox blocks generated chunk by chunk into a stack buffer, and the number used for
+     * weight i depends only on (seed, stream, i). So any slice of the buffer may be processed separately
+     * (e.g. in parallel) with the same result, and noise may be regenerated later instead of being stored.
+     * Inner loops have no calls and no data-dependent branches, so they are vectorized by the compiler.
+     */
+    namespace weight_ops {
+        static constexpr size_t CHUNK = 1024;
+
+        // Sum of four uniform bytes: mean 4 * 127.5, variance 4 * (256^2 - 1) / 12
+        static constexpr FloatT BYTE_SUM_MEAN    = FloatT(510);
+        static constexpr FloatT BYTE_SUM_INV_STD = FloatT(1 / 147.80054127);
+
+        // Stream offset of the mutation mask, so the mask doesn't correlate with the noise
+        static constexpr uint64_t MASK_STREAM = 0x6D61736B;
+
+        /**
+         * Call fn(random, i, n) for consecutive chunks of [0, count) where random[k] is the random
+         * number of the element first + i + k
+         */
+        template <typename F>
+        void foreach_random_chunk(size_t count, uint64_t seed, uint64_t stream, uint64_t first, F&& fn) {
+            uint32_t buffer[CHUNK + 4];
+
+            for (size_t i = 0; i < count; i += CHUNK) {
+                auto n      = std::min(CHUNK, count - i);
+                auto pos    = first + i;
+                auto offset = pos % 4;
+                auto blocks = (offset + n + 3) / 4;
+
+                Philox4x32::generate(seed, stream, pos / 4, buffer, blocks);
+                fn(buffer + offset, i, n);
+            }
+        }
+
+        /**
+         * Call fn(k) for k in [0, n), full chunks get the loop with constant trip count,
+         * which is vectorized by -O2 too (no scalar epilogue is needed)
+         */
+        template <typename F>
+        inline void chunk_loop(size_t n, F&& fn) {
+            if (n == CHUNK) {
+                for (size_t k = 0; k < CHUNK; ++k)
+                    fn(k);
+            }
+            else {
+                for (size_t k = 0; k < n; ++k)
+                    fn(k);
+            }
+        }
+
+        inline FloatT byte_sum_normal(uint32_t r) {
+            auto sum = (r & 0xFFU) + ((r >> 8U) & 0xFFU) + ((r >> 16U) & 0xFFU) + (r >> 24U);
+            return (FloatT(sum) - BYTE_SUM_MEAN) * BYTE_SUM_INV_STD;
+        }
+
+        /**
+         * Approximately standard normal noise for elements [first, first + count) of the stream
+         * Every value is the sum of four uniform bytes of one random number (Irwin-Hall, n = 4) scaled
+         * to the unit variance: symmetric and bell-shaped, tails are cut at ~3.45 sigma.
+         *
+         * @param dst - destination
+         * @param count - count of values
+         * @param seed - seed
+         * @param stream - stream (e.g. individual or perturbation index)
+         * @param first - index of the first element in the stream
+         */
+        inline void gaussian_noise(FloatT* dst, size_t count, uint64_t seed, uint64_t stream, uint64_t first = 0) {
+            foreach_random_chunk(count, seed, stream, first, [dst](const uint32_t* random, size_t i, size_t n) {
+                auto out = dst + i;
+                chunk_loop(n, [=](size_t k) { out[k] = byte_sum_normal(random[k]); });
+            });
+        }
+
+        /**
+         * weights[i] += sigma * noise[first + i], noise is the same as gaussian_noise() of the stream
+         */
+        inline void perturb_gaussian(FloatT* weights, size_t count, FloatT sigma,
+                                     uint64_t seed, uint64_t stream, uint64_t first = 0) {
+            foreach_random_chunk(count, seed, stream, first, [=](const uint32_t* random, size_t i, size_t n) {
+                auto w = weights + i;
+                chunk_loop(n, [=](size_t k) { w[k] += sigma * byte_sum_normal(random[k]); });
+            });
+        }
+
+        /**
+         * Gaussian perturbation of the random subset of weights, every weight is selected with the probability
+         * Mask is a dense compare against a second stream (not skipping), so the selection of weight i doesn't
+         * depend on how the buffer is split into slices.
+         */
+        inline void perturb_gaussian_sparse(FloatT* weights, size_t count, FloatT sigma, FloatT probability,
+                                            uint64_t seed, uint64_t stream, uint64_t first = 0) {
+            if (probability <= 0)
+                return;
+
+            if (probability >= 1) {
+                perturb_gaussian(weights, count, sigma, seed, stream, first);
+                return;
+            }
+
+            auto threshold   = static_cast<uint32_t>(double(probability) * 4294967296.0);
+            auto mask_stream = Philox4x32::mix(stream, MASK_STREAM);
+
+            foreach_random_chunk(count, seed, mask_stream, first, [&](const uint32_t* mask, size_t i, size_t n) {
+                uint32_t noise_buffer[CHUNK + 4];
+
+                auto pos    = first + i;
+                auto offset = pos % 4;
+                Philox4x32::generate(seed, stream, pos / 4, noise_buffer, (offset + n + 3) / 4);
+
+                auto noise = noise_buffer + offset;
+                auto w     = weights + i;
+
+                chunk_loop(n, [=](size_t k) {
+                    w[k] += mask[k] < threshold ? sigma * byte_sum_normal(noise[k]) : FloatT(0);
+                });
+            });
+        }
+
+        /**
+         * child[i] = random bit ? b[i] : a[i], every random number gives 32 bits
+         * child may alias a or b
+         */
+        inline void crossover_uniform(const FloatT* a, const FloatT* b, FloatT* child, size_t count,
+                                      uint64_t seed, uint64_t stream) {
+            auto words = (count + 31) / 32;
+
+            foreach_random_chunk(words, seed, stream, 0, [=](const uint32_t* random, size_t word, size_t n) {
+                for (size_t w = 0; w < n; ++w) {
+                    auto bits  = random[w];
+                    auto begin = (word + w) * 32;
+
+                    auto pa = a + begin;
+                    auto pb = b + begin;
+                    auto pc = child + begin;
+
+                    auto select = [=](size_t j) {
+                        auto av = pa[j];
+                        auto bv = pb[j];
+                        pc[j] = (bits >> j) & 1U ? bv : av;
+                    };
+
+                    if (begin + 32 <= count) {
+                        for (size_t j = 0; j < 32; ++j)
+                            select(j);
+                    }
+                    else {
+                        for (size_t j = 0; j < count - begin; ++j)
+                            select(j);
+                    }
+                }
+            });
+        }
+
+        /**
+         * child[i] = a[i] + alpha * (b[i] - a[i]), child may alias a or b
+         */
+        inline void crossover_arithmetic(const FloatT* a, const FloatT* b, FloatT* child, size_t count, FloatT alpha) {
+            for (size_t i = 0; i < count; ++i)
+                child[i] = a[i] + alpha * (b[i] - a[i]);
+        }
+    }
+}
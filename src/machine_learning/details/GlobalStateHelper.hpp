@@ -2,6 +2,9 @@
 
 #include <random>
 #include <ctime>
+#include <mutex>
+
+#include "../../core/Philox.hpp"
 
 namespace nnw {
     class GlobalStateHelper {
@@ -24,25 +27,38 @@ namespace nnw {
 
         template <typename T>
         auto uniform_dist(T min, T max) -> std::enable_if_t<std::is_integral_v<T>, T> {
-            return std::uniform_int_distribution<T>(min, max)(_mt);
+            auto lock = std::lock_guard(_mutex);
+            return std::uniform_int_distribution<T>(min, max)(_rng);
         }
 
         template <typename T>
         auto uniform_dist(T min, T max) -> std::enable_if_t<std::is_floating_point_v<T>, T> {
-            return std::uniform_real_distribution<T>(min, max)(_mt);
+            auto lock = std::lock_guard(_mutex);
+            return std::uniform_real_distribution<T>(min, max)(_rng);
+        }
+
+        void seed(uint64_t value) {
+            auto lock = std::lock_guard(_mutex);
+            _rng = Philox4x32(value);
         }
 
-        void init_mt19937() {
-            _mt = std::mt19937(static_cast<size_t>(std::time(nullptr)));
+        /**
+         * Independent generator for the id (thread, individual, sample), depends only on the seed and the id
+         */
+        Philox4x32 stream(uint64_t id) {
+            auto lock = std::lock_guard(_mutex);
+            return _rng.split(id);
         }
 
     private:
-        GlobalStateHelper() /* : _mt(static_cast<size_t>(std::time(nullptr))) */ {}
+        GlobalStateHelper() = default;
         ~GlobalStateHelper() = default;
 
         size_t _current_neuron  = 0;
         size_t _current_synapse = 0;
-        std::mt19937 _mt;
+
+        std::mutex _mutex;
+        Philox4x32 _rng;
     };
 
     namespace helper {
@@ -60,7 +76,15 @@ namespace nnw {
         }
 
         inline void randomize() {
-            GlobalStateHelper::instance().init_mt19937();
+            GlobalStateHelper::instance().seed(static_cast<uint64_t>(std::time(nullptr)));
+        }
+
+        inline void seed(uint64_t value) {
+            GlobalStateHelper::instance().seed(value);
+        }
+
+        inline Philox4x32 rng_stream(uint64_t id) {
+            return GlobalStateHelper::instance().stream(id);
         }
     }
 }
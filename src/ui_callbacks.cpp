@@ -1,13 +1,18 @@
 #include "Engine.hpp"
 #include "graphics/nuklear.hpp"
 #include "EngineState.hpp"
+#include "game/SimulationRecording.hpp"
 
 Window::UiCallbackT Engine::uiPhysics(DrawableManagerSP& drawable_manager) {
     return [this, drawable_manager](Window&, NkCtx* ctx) {
-        if (!physic_simulation)
+        if (!physic_thread)
             return;
 
-        if (nk_begin(ctx, "Physics", nk_rect(200, 20, 200, 400),
+        // Values are shown from the latest frame, changes are sent to the physics thread as commands
+        auto& frame    = physic_thread->frame();
+        auto& settings = frame.settings;
+
+        if (nk_begin(ctx, "Physics", nk_rect(200, 20, 260, 680),
                      NK_WINDOW_BORDER|NK_WINDOW_MOVABLE|NK_WINDOW_SCALABLE|
                      NK_WINDOW_MINIMIZABLE|NK_WINDOW_TITLE)) {
 
@@ -16,57 +21,106 @@ Window::UiCallbackT Engine::uiPhysics(DrawableManagerSP& drawable_manager) {
 
             nk_layout_row_dynamic(ctx, 25, 1);
             nk_label(ctx, scl::String().sprintf(
-                    "Time: {:.2f} s.", physic_simulation->simulation_time()).data(), NK_TEXT_CENTERED);
+                    "Time: {:.2f} s.", frame.simulation_time).data(), NK_TEXT_CENTERED);
 
 
             nk_layout_row_dynamic(ctx, 25, 1);
             if (nk_button_label(ctx, "Step")) {
-                physic_simulation->step();
+                physic_thread->post([](PhysicSimulation& it) { it.step(); });
             }
 
-            static int on_pause = physic_simulation->on_pause();
+            int on_pause = settings.on_pause;
             nk_layout_row_dynamic(ctx, 25, 1);
             if (nk_checkbox_label(ctx, "On pause", &on_pause)) {
-                physic_simulation->on_pause(on_pause);
+                physic_thread->post([on_pause](PhysicSimulation& it) { it.on_pause(on_pause); });
             }
 
-            static int enable_debug_draw = physic_simulation->debug_draw();
+            int enable_debug_draw = settings.debug_draw;
             nk_layout_row_dynamic(ctx, 25, 1);
             if (nk_checkbox_label(ctx, "Enable debug draw", &enable_debug_draw)) {
-                physic_simulation->debug_draw(enable_debug_draw);
+                physic_thread->post([enable_debug_draw](PhysicSimulation& it) { it.debug_draw(enable_debug_draw); });
             }
 
-            static int enable_adaptive_timestep = physic_simulation->adaptive_timestep();
+            int enable_force_update = settings.force_update;
             nk_layout_row_dynamic(ctx, 25, 1);
-            if (nk_checkbox_label(ctx, "Adaptive timestep", &enable_adaptive_timestep))
-                physic_simulation->adaptive_timestep(enable_adaptive_timestep);
+            if (nk_checkbox_label(ctx, "Force update", &enable_force_update))
+                    physic_thread->post([enable_force_update](PhysicSimulation& it) {
+                        it.force_update(enable_force_update);
+                    });
 
-            static int enable_force_update = physic_simulation->force_update();
             nk_layout_row_dynamic(ctx, 25, 1);
-            if (nk_checkbox_label(ctx, "Force update", &enable_force_update))
-                    physic_simulation->force_update(enable_force_update);
+            auto slowdown = nk_propertyd(ctx, "Slowdown factor", 1, settings.slowdown_factor, 30, 1, 1);
+            if (slowdown != settings.slowdown_factor)
+                physic_thread->post([slowdown](PhysicSimulation& it) { it.slowdown_factor(slowdown); });
 
             nk_layout_row_dynamic(ctx, 25, 1);
-            auto slowdown = physic_simulation->slowdown_factor();
-            slowdown = nk_propertyd(ctx, "Slowdown factor", 1, slowdown, 30, 1, 1);
-            physic_simulation->slowdown_factor(slowdown);
+            int freq     = (int)round(1.0 / settings.step_time);
+            int new_freq = nk_propertyi(ctx, "Frequency", int(std::ceil(1.0 / PhysicSimulation::MIN_STEP)), freq, 960, 1, 3);
+            if (new_freq != freq)
+                physic_thread->post([new_freq](PhysicSimulation& it) { it.step_time(1.f / new_freq); });
 
             nk_layout_row_dynamic(ctx, 25, 1);
-            int freq = (int)round(1.0 / physic_simulation->step_time());
-            freq = nk_propertyi(ctx, "Frequency", 5, freq, 960, 1, 3);
-            physic_simulation->step_time(1.f / freq);
+            int catch_up = nk_propertyi(ctx, "Max catch-up steps", 1, int(settings.max_catch_up_steps), 100, 1, 1);
+            if (catch_up != int(settings.max_catch_up_steps))
+                physic_thread->post([catch_up](PhysicSimulation& it) { it.max_catch_up_steps(uint32_t(catch_up)); });
 
 
+            // Iterations affect the solution, they are changed by the command to be recorded
+            auto post_iterations = [this](int velocity, int position) {
+                physic_thread->post([velocity, position](PhysicSimulation& it) {
+                    auto command = SimulationCommand{SimulationCommand::SetIterations};
+                    command.values = {float(velocity), float(position)};
+                    it.execute(command);
+                });
+            };
+
             nk_layout_row_dynamic(ctx, 25, 1);
-            int vel_iters = physic_simulation->velocity_iters();
-            vel_iters = nk_propertyi(ctx, "Velocity iters", 1, vel_iters, 1000, 1, 3);
-            physic_simulation->velocity_iters(vel_iters);
+            int vel_iters = nk_propertyi(ctx, "Velocity iters", 1, settings.velocity_iters, 1000, 1, 3);
+            if (vel_iters != settings.velocity_iters)
+                post_iterations(vel_iters, settings.position_iters);
 
 
             nk_layout_row_dynamic(ctx, 25, 1);
-            int pos_iters = physic_simulation->position_iters();
-            pos_iters = nk_propertyi(ctx, "Position iters", 1, pos_iters, 1000, 1, 3);
-            physic_simulation->position_iters(pos_iters);
+            int pos_iters = nk_propertyi(ctx, "Position iters", 1, settings.position_iters, 1000, 1, 3);
+            if (pos_iters != settings.position_iters)
+                post_iterations(settings.velocity_iters, pos_iters);
+
+            // The recording starts from a world without objects (reset it with R), see SimulationRecording
+            nk_layout_row_dynamic(ctx, 25, 1);
+            if (!settings.recording) {
+                if (nk_button_label(ctx, "Start recording"))
+                    physic_thread->post([](PhysicSimulation& it) { it.startRecording(); });
+            }
+            else if (nk_button_label(ctx, "Stop and save recording")) {
+                physic_thread->post([](PhysicSimulation& it) {
+                    if (auto recording = it.stopRecording())
+                        recording->save("simulation.simrec");
+                });
+            }
+
+            // Step timings
+            auto& profile = frame.profile;
+
+            nk_layout_row_dynamic(ctx, 25, 1);
+            nk_label(ctx, scl::String().sprintf(
+                    "Step timings, ms ({} steps)", profile.steps).data(), NK_TEXT_CENTERED);
+
+            nk_layout_row_dynamic(ctx, 20, 4);
+            nk_label(ctx, "",    NK_TEXT_LEFT);
+            nk_label(ctx, "p50", NK_TEXT_RIGHT);
+            nk_label(ctx, "p95", NK_TEXT_RIGHT);
+            nk_label(ctx, "max", NK_TEXT_RIGHT);
+
+            auto fields = StepProfile::fields();
+            auto names  = StepProfile::field_names();
+
+            for (size_t i = 0; i < fields.size(); ++i) {
+                nk_layout_row_dynamic(ctx, 20, 4);
+                nk_label(ctx, names[i], NK_TEXT_LEFT);
+
+                for (auto& stats : {profile.median, profile.p95, profile.max})
+                    nk_label(ctx, scl::String().sprintf("{:.3f}", stats.*fields[i]).data(), NK_TEXT_RIGHT);
+            }
         }
         nk_end(ctx);
     };
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <optional>
+#include <cstdio>
+#include <utility>
+
+#include "ReaderWriter.hpp"
+
+
+/**
+ * Writes prepared byte buffers to disk on a background thread
+ *
+ * write() only moves the buffer into the pending slot and returns. If the disk is slower than the producer,
+ * a newer pending buffer replaces the older one which was not started yet, so the producer never blocks
+ * and the file always ends up with the latest data. Every file is written to '<path>.tmp' and then renamed,
+ * so a crash during writing never leaves a truncated file at the destination path.
+ */
+class AsyncFileWriter {
+public:
+    AsyncFileWriter(): _thread(&AsyncFileWriter::worker_loop, this) {}
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    ~AsyncFileWriter() {
+        {
+            auto lock = std::lock_guard(_mutex);
+            _stop = true;
+        }
+
+        _cv.notify_all();
+        _thread.join();
+    }
+
+    /**
+     * Schedule writing of data to the file
+     * Error of the previous write (if any) is rethrown here
+     *
+     * @param path - destination file path
+     * @param data - file content
+     */
+    void write(const std::string& path, std::vector<uint8_t>&& data) {
+        {
+            auto lock = std::lock_guard(_mutex);
+            rethrow_error();
+
+            if (_pending)
+                ++_skipped;
+
+            _pending = Job{path, std::move(data)};
+        }
+
+        _cv.notify_all();
+    }
+
+    /**
+     * Wait until all scheduled data is written
+     * Error of the last write (if any) is rethrown here
+     */
+    void flush() {
+        auto lock = std::unique_lock(_mutex);
+        _cv.wait(lock, [this] { return !_pending && !_busy; });
+        rethrow_error();
+    }
+
+    /**
+     * @return count of buffers replaced by newer ones before they were written
+     */
+    size_t skipped() const {
+        auto lock = std::lock_guard(_mutex);
+        return _skipped;
+    }
+
+private:
+    struct Job {
+        std::string          path;
+        std::vector<uint8_t> data;
+    };
+
+    void rethrow_error() {
+        if (_error)
+            std::rethrow_exception(std::exchange(_error, nullptr));
+    }
+
+    static void write_file(const Job& job) {
+        auto tmp_path = job.path + ".tmp";
+
+        {
+            auto file = Writer(tmp_path);
+            file.write(job.data.data(), job.data.size());
+        }
+
+        if (std::rename(tmp_path.data(), job.path.data()) != 0)
+            throw std::runtime_error("Can't rename file '" + tmp_path + "' to '" + job.path + "'");
+    }
+
+    void worker_loop() {
+        while (true) {
+            Job job;
+
+            {
+                auto lock = std::unique_lock(_mutex);
+                _cv.wait(lock, [this] { return _stop || _pending; });
+
+                if (!_pending)
+                    return;
+
+                job   = std::move(*_pending);
+                _busy = true;
+                _pending.reset();
+            }
+
+            std::exception_ptr error;
+
+            try {
+                write_file(job);
+            }
+            catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                auto lock = std::lock_guard(_mutex);
+                _busy = false;
+
+                if (error)
+                    _error = error;
+            }
+
+            _cv.notify_all();
+        }
+    }
+
+private:
+    mutable std::mutex      _mutex;
+    std::condition_variable _cv;
+    std::optional<Job>      _pending;
+    std::exception_ptr      _error;
+    size_t                  _skipped = 0;
+    bool                    _busy    = false;
+    bool                    _stop    = false;
+
+    std::thread _thread;
+};
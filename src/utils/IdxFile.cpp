@@ -0,0 +1,146 @@
+#include "IdxFile.hpp"
+
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+IdxFile::IdxFile(const std::string& path) {
+    int fd = ::open(path.data(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("Can't open file '" + path + "'");
+
+    struct stat st = {};
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw std::runtime_error("IdxFile::IdxFile(): can't stat file '" + path + "'");
+    }
+
+    _size = static_cast<size_t>(st.st_size);
+
+    if (_size > 0) {
+        auto addr = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (addr == MAP_FAILED)
+            throw std::runtime_error("IdxFile::IdxFile(): can't map file '" + path + "'");
+
+        _data   = static_cast<const uint8_t*>(addr);
+        _mapped = true;
+
+        // Samples are usually read in random order
+        madvise(addr, _size, MADV_RANDOM);
+    }
+    else {
+        ::close(fd);
+    }
+
+    try {
+        parse_header();
+    }
+    catch (...) {
+        release();
+        throw;
+    }
+}
+
+IdxFile IdxFile::from_memory(std::string data) {
+    auto file = IdxFile();
+
+    file._buffer = std::move(data);
+    file._data   = reinterpret_cast<const uint8_t*>(file._buffer.data());
+    file._size   = file._buffer.size();
+    file.parse_header();
+
+    return file;
+}
+
+IdxFile::IdxFile(IdxFile&& f) noexcept {
+    *this = std::move(f);
+}
+
+IdxFile& IdxFile::operator=(IdxFile&& f) noexcept {
+    if (this == &f)
+        return *this;
+
+    release();
+
+    auto payload_offset = static_cast<size_t>(f._payload - f._data);
+
+    _buffer = std::move(f._buffer);
+    _size   = f._size;
+    _mapped = f._mapped;
+    _dtype  = f._dtype;
+    _dims   = std::move(f._dims);
+
+    // Moved string may change its data pointer (small buffer)
+    _data    = _mapped ? f._data : reinterpret_cast<const uint8_t*>(_buffer.data());
+    _payload = _data + payload_offset;
+
+    f._data    = nullptr;
+    f._payload = nullptr;
+    f._size    = 0;
+    f._mapped  = false;
+
+    return *this;
+}
+
+IdxFile::~IdxFile() {
+    release();
+}
+
+void IdxFile::release() {
+    if (_mapped)
+        munmap(const_cast<uint8_t*>(_data), _size);
+
+    _mapped = false;
+    _data   = nullptr;
+}
+
+size_t IdxFile::dtype_size() const {
+    switch (_dtype) {
+        case DType::UInt8:
+        case DType::Int8:    return 1;
+        case DType::Int16:   return 2;
+        case DType::Int32:
+        case DType::Float32: return 4;
+        case DType::Float64: return 8;
+    }
+    return 0;
+}
+
+void IdxFile::parse_header() {
+    if (_size < 4 || _data[0] != 0 || _data[1] != 0)
+        throw std::runtime_error("IdxFile::parse_header(): Wrong magic number!");
+
+    _dtype = static_cast<DType>(_data[2]);
+
+    if (dtype_size() == 0)
+        throw std::runtime_error("IdxFile::parse_header(): unknown dtype");
+
+    size_t rank        = _data[3];
+    size_t header_size = 4 + rank * 4;
+
+    if (_size < header_size)
+        throw std::runtime_error("IdxFile::parse_header(): unexpected end of file");
+
+    _dims.resize(rank);
+    for (size_t i = 0; i < rank; ++i)
+        _dims[i] = idx_load<uint32_t>(_data + 4 + i * 4);
+
+    _payload = _data + header_size;
+
+    // Dimensions come from the file, so their product may overflow: the payload size is divided by them instead
+    if (std::find(_dims.begin(), _dims.end(), 0) != _dims.end())
+        return;
+
+    auto available = (_size - header_size) / dtype_size();
+
+    for (auto dim : _dims) {
+        if (available < dim)
+            throw std::runtime_error("IdxFile::parse_header(): file is smaller than declared tensor size");
+
+        available /= dim;
+    }
+}
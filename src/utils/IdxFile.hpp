@@ -0,0 +1,262 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+
+
+/**
+ * Reads element of type T stored in big-endian byte order (IDX files are always big-endian)
+ */
+template <typename T>
+static inline T idx_load(const uint8_t* src) {
+    if constexpr (sizeof(T) == 1) {
+        return static_cast<T>(*src);
+    }
+    else {
+        using UIntT = std::conditional_t<sizeof(T) == 2, uint16_t,
+                      std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>>;
+
+        UIntT bits = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+            bits = static_cast<UIntT>((bits << 8U) | src[i]);
+
+        T res;
+        memcpy(&res, &bits, sizeof(T));
+        return res;
+    }
+}
+
+
+/**
+ * Typed strided view of IDX tensor
+ *
+ * Does not own the data, valid while IdxFile lives.
+ * operator[] drops the first dimension, so view[i] of images tensor is the i-th image.
+ */
+template <typename T>
+class IdxView {
+public:
+    IdxView(const uint8_t* data, std::vector<size_t> dims, std::vector<size_t> strides):
+        _data(data), _dims(std::move(dims)), _strides(std::move(strides)) {}
+
+    IdxView operator[](size_t i) const {
+        if (_dims.empty() || i >= _dims.front())
+            throw std::out_of_range("IdxView::operator[](): index out of bounds");
+
+        return IdxView(_data + i * _strides.front() * sizeof(T),
+                       std::vector<size_t>(_dims.begin() + 1, _dims.end()),
+                       std::vector<size_t>(_strides.begin() + 1, _strides.end()));
+    }
+
+    /**
+     * Sub-range of the first dimension
+     * @param begin - first index
+     * @param count - count of elements
+     */
+    IdxView slice(size_t begin, size_t count) const {
+        if (_dims.empty() || begin + count > _dims.front())
+            throw std::out_of_range("IdxView::slice(): range out of bounds");
+
+        auto dims = _dims;
+        dims.front() = count;
+
+        return IdxView(_data + begin * _strides.front() * sizeof(T), std::move(dims), _strides);
+    }
+
+    /**
+     * Element by full index
+     */
+    template <typename... IdxT>
+    T operator()(IdxT... indices) const {
+        static_assert((std::is_integral_v<IdxT> && ...), "Indices must be integral");
+
+        if (sizeof...(IdxT) != _dims.size())
+            throw std::invalid_argument("IdxView::operator()(): indices count != rank");
+
+        size_t offset = 0;
+        size_t dim    = 0;
+        ((offset += static_cast<size_t>(indices) * _strides[dim++]), ...);
+
+        return idx_load<T>(_data + offset * sizeof(T));
+    }
+
+    /**
+     * Copy all elements (row-major) with conversion: dst[i] = U(value) * scale
+     * @param dst - destination, must have size() elements
+     * @param scale - multiplier (e.g. 1/255 for normalization of 8-bit images)
+     */
+    template <typename U>
+    void copy_to(U* dst, U scale = U(1)) const {
+        copy_dim(dst, _data, 0, scale);
+    }
+
+    size_t rank() const {
+        return _dims.size();
+    }
+
+    size_t dim(size_t i) const {
+        return _dims[i];
+    }
+
+    size_t stride(size_t i) const {
+        return _strides[i];
+    }
+
+    // Elements count
+    size_t size() const {
+        size_t res = 1;
+        for (auto d : _dims)
+            res *= d;
+        return res;
+    }
+
+    const std::vector<size_t>& dims() const {
+        return _dims;
+    }
+
+private:
+    template <typename U>
+    U* copy_dim(U* dst, const uint8_t* src, size_t dim, U scale) const {
+        if (dim == _dims.size()) {
+            *dst = static_cast<U>(idx_load<T>(src)) * scale;
+            return dst + 1;
+        }
+
+        // Innermost contiguous dimension
+        if (dim + 1 == _dims.size() && _strides[dim] == 1) {
+            for (size_t i = 0; i < _dims[dim]; ++i)
+                dst[i] = static_cast<U>(idx_load<T>(src + i * sizeof(T))) * scale;
+            return dst + _dims[dim];
+        }
+
+        for (size_t i = 0; i < _dims[dim]; ++i)
+            dst = copy_dim(dst, src + i * _strides[dim] * sizeof(T), dim + 1, scale);
+
+        return dst;
+    }
+
+private:
+    const uint8_t*      _data;
+    std::vector<size_t> _dims;
+    std::vector<size_t> _strides; // In elements
+};
+
+
+/**
+ * IDX tensor file (MNIST, Fashion-MNIST, EMNIST format)
+ *
+ * Header: 2 zero bytes, dtype byte, rank byte, rank * big-endian uint32 dimensions, then data.
+ * Files are memory-mapped, so opening is O(1) and samples are read on access.
+ * Compressed data must be decompressed first and passed to from_memory().
+ */
+class IdxFile {
+public:
+    enum class DType : uint8_t {
+        UInt8   = 0x08,
+        Int8    = 0x09,
+        Int16   = 0x0B,
+        Int32   = 0x0C,
+        Float32 = 0x0D,
+        Float64 = 0x0E
+    };
+
+    /**
+     * Memory-map file
+     * @param path - path to uncompressed IDX file
+     */
+    explicit IdxFile(const std::string& path);
+
+    /**
+     * Take ownership of in-memory IDX data (e.g. decompressed .gz file)
+     * @param data - uncompressed IDX file content
+     */
+    static IdxFile from_memory(std::string data);
+
+    IdxFile(IdxFile&& f) noexcept;
+    IdxFile& operator=(IdxFile&& f) noexcept;
+
+    IdxFile(const IdxFile&) = delete;
+    IdxFile& operator=(const IdxFile&) = delete;
+
+    ~IdxFile();
+
+    /**
+     * Typed view of the whole tensor
+     * Throws if T doesn't match file dtype
+     */
+    template <typename T>
+    IdxView<T> view() const {
+        if (!dtype_is<T>())
+            throw std::runtime_error("IdxFile::view(): requested type doesn't match file dtype");
+
+        std::vector<size_t> strides(_dims.size(), 1);
+        for (size_t i = _dims.size(); i-- > 1;)
+            strides[i - 1] = strides[i] * _dims[i];
+
+        return IdxView<T>(_payload, _dims, std::move(strides));
+    }
+
+    template <typename T>
+    bool dtype_is() const {
+        switch (_dtype) {
+            case DType::UInt8:   return std::is_same_v<T, uint8_t>;
+            case DType::Int8:    return std::is_same_v<T, int8_t>;
+            case DType::Int16:   return std::is_same_v<T, int16_t>;
+            case DType::Int32:   return std::is_same_v<T, int32_t>;
+            case DType::Float32: return std::is_same_v<T, float>;
+            case DType::Float64: return std::is_same_v<T, double>;
+        }
+        return false;
+    }
+
+    DType dtype() const {
+        return _dtype;
+    }
+
+    size_t dtype_size() const;
+
+    size_t rank() const {
+        return _dims.size();
+    }
+
+    const std::vector<size_t>& dims() const {
+        return _dims;
+    }
+
+    // Size of the first dimension
+    size_t count() const {
+        return _dims.empty() ? 1 : _dims.front();
+    }
+
+    // Elements count of one sample (product of all dimensions except the first)
+    size_t sample_size() const {
+        size_t res = 1;
+        for (size_t i = 1; i < _dims.size(); ++i)
+            res *= _dims[i];
+        return res;
+    }
+
+    bool is_mapped() const {
+        return _mapped;
+    }
+
+private:
+    IdxFile() = default;
+
+    void parse_header();
+    void release();
+
+private:
+    std::string    _buffer;            // Owned data for from_memory()
+    const uint8_t* _data    = nullptr; // Whole file
+    size_t         _size    = 0;
+    const uint8_t* _payload = nullptr; // Tensor data
+    bool           _mapped  = false;
+
+    DType               _dtype = DType::UInt8;
+    std::vector<size_t> _dims;
+};
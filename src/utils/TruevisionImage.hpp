@@ -3,6 +3,12 @@
 #include <string>
 #include <cstring>
 #include <vector>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
 #include <scl/vector.hpp>
 
 #include "ReaderWriter.hpp"
@@ -147,59 +153,197 @@ namespace fft {
             return *this;
         }
 
-        void load(const StringT& path) {
+        ~TruevisionImage() {
             delete [] _data;
+        }
 
-            auto ds = Reader(path);
+        /**
+         * Load uncompressed (types 2, 3) or RLE-compressed (types 10, 11) image
+         * @param path - path to image
+         */
+        void load(const StringT& path) {
+            auto is = std::ifstream(path, std::ios::in | std::ios::binary);
+            if (!is.is_open())
+                throw TtfException("Can't open file '" + path + "'");
 
-            ds.skip(2);
-            _type = ds.read<Type>();
+            auto file = std::vector<uint8_t>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
 
-            if (!check_type(_type))
-                throw TtfException("Unsupported ttf image type");
+            if (file.size() < HEADER_SIZE)
+                throw TtfException("TruevisionImage::load(): unexpected end of file");
+
+            auto u16 = [&](size_t pos) {
+                return static_cast<uint16_t>(file[pos] | (file[pos + 1] << 8U));
+            };
+
+            auto id_length = file[0];
+            auto raw_type  = file[2];
+            bool rle       = raw_type & RLE_FLAG;
+            auto type      = static_cast<Type>(raw_type & ~RLE_FLAG);
+
+            if (HEADER_SIZE + id_length > file.size())
+                throw TtfException("TruevisionImage::load(): unexpected end of file");
 
-            ds.skip(9);
-            _width  = ds.read<uint16_t>();
-            _height = ds.read<uint16_t>();
+            if (!check_type(type))
+                throw TtfException("Unsupported ttf image type");
 
-            auto bpp = ds.read<uint8_t>();
+            auto bpp = file[16];
 
-            if (_type == Type::Monochrome && bpp != 8)
+            if (type == Type::Monochrome && bpp != 8)
                 throw TtfException("Unknown bit per pixel in monochrome image: " + std::to_string(bpp));
 
-            if (_type == Type::TrueColor && bpp != 24)
+            if (type == Type::TrueColor && bpp != 24)
                 throw TtfException("Unsupported bit per pixel in TrueColor image: " + std::to_string(bpp));
 
-            ds.skip(1);
+            init(type, u16(12), u16(14));
 
-            _data = new uint8_t[_width * _height * bytes_per_pixel(_type)]();
-            ds.read(_data, _width * _height * bytes_per_pixel(_type));
+            auto pixel_size = bytes_per_pixel(_type);
+            auto size       = _width * _height * pixel_size;
+            auto src        = file.data() + HEADER_SIZE + id_length;
+            auto end        = file.data() + file.size();
+
+            if (!rle) {
+                if (size_t(end - src) < size)
+                    throw TtfException("TruevisionImage::load(): unexpected end of file");
+
+                std::memcpy(_data, src, size);
+                return;
+            }
+
+            for (size_t pos = 0; pos < size;) {
+                if (src >= end)
+                    throw TtfException("TruevisionImage::load(): unexpected end of file");
+
+                auto packet = *src++;
+                auto count  = (packet & 0x7fU) + 1;
+                auto bytes  = count * pixel_size;
+
+                if (pos + bytes > size)
+                    throw TtfException("TruevisionImage::load(): RLE packet overflows image");
+
+                if (packet & 0x80U) {
+                    if (size_t(end - src) < pixel_size)
+                        throw TtfException("TruevisionImage::load(): unexpected end of file");
+
+                    for (size_t i = 0; i < count; ++i)
+                        std::memcpy(_data + pos + i * pixel_size, src, pixel_size);
+                    src += pixel_size;
+                }
+                else {
+                    if (size_t(end - src) < bytes)
+                        throw TtfException("TruevisionImage::load(): unexpected end of file");
+
+                    std::memcpy(_data + pos, src, bytes);
+                    src += bytes;
+                }
+
+                pos += bytes;
+            }
         }
 
-        void save(const StringT& path) const {
-            auto w = Writer();
-            // Header
-            w.write<uint8_t>(0); // Identifier (no ID)
-            w.write<uint8_t>(0); // Color map type (no map)
-            w.write<uint8_t>(static_cast<uint8_t>(_type)); // TrueColor type
-            w.zero_fill(5); // color map (empty)
+        /**
+         * Encode whole file (header, pixels, footer) to the buffer
+         * @param out - output buffer, previous content is replaced, capacity is reused
+         * @param rle - use RLE compression (types 10, 11)
+         */
+        void encode(std::vector<uint8_t>& out, bool rle = false) const {
+            auto pixel_size = bytes_per_pixel(_type);
 
-            w.write<uint16_t>(0); // pos X
-            w.write<uint16_t>(0); // pos Y
-            w.write<uint16_t>(static_cast<uint16_t>(_width)); // size X
-            w.write<uint16_t>(static_cast<uint16_t>(_height)); // size Y
-            w.write<uint8_t>(static_cast<uint8_t>(bytes_per_pixel(_type) * 8)); // 24 bits per pixel
-            w.zero_fill(1);      // image descriptor
+            out.clear();
+            out.reserve(HEADER_SIZE + FOOTER_SIZE + _width * _height * pixel_size + (rle ? _height * (_width / 128 + 1) : 0));
 
-            w.write(_data, _width * _height * bytes_per_pixel(_type));
+            auto put16 = [&](size_t value) {
+                out.push_back(static_cast<uint8_t>(value & 0xffU));
+                out.push_back(static_cast<uint8_t>((value >> 8U) & 0xffU));
+            };
+
+            // Header
+            out.push_back(0); // Identifier (no ID)
+            out.push_back(0); // Color map type (no map)
+            out.push_back(static_cast<uint8_t>(static_cast<uint8_t>(_type) | (rle ? RLE_FLAG : 0))); // Image type
+            out.insert(out.end(), 5, 0); // color map (empty)
+
+            put16(0); // pos X
+            put16(0); // pos Y
+            put16(_width);  // size X
+            put16(_height); // size Y
+            out.push_back(static_cast<uint8_t>(pixel_size * 8)); // bits per pixel
+            out.push_back(0); // image descriptor
+
+            if (rle) {
+                for (size_t i = 0; i < _height; ++i)
+                    encode_rle_row((*this)[i], _width, pixel_size, out);
+            }
+            else {
+                out.insert(out.end(), _data, _data + _width * _height * pixel_size);
+            }
 
             // Footer
-            w.zero_fill(8);
-            w.write(StringT("TRUEVISION-XFILE"));
-            w.write('.');
-            w.write<uint8_t>(0);
+            out.insert(out.end(), 8, 0);
+            for (auto c : StringT("TRUEVISION-XFILE."))
+                out.push_back(static_cast<uint8_t>(c));
+            out.push_back(0);
+        }
 
-            w.attach_to(path);
+        /**
+         * @param path - output file path
+         * @param rle - use RLE compression
+         */
+        void save(const StringT& path, bool rle = false) const {
+            auto buffer = std::vector<uint8_t>();
+            encode(buffer, rle);
+            write_file(path, buffer);
+        }
+
+        /**
+         * Parallel export of many images
+         *
+         * Every thread reuses one image and one encode buffer, every file is written with one call.
+         * Exception from any thread is rethrown after all threads are finished.
+         *
+         * @param count - count of images
+         * @param producer - fills the image with index i and returns its path, called concurrently
+         * @param rle - use RLE compression
+         * @param threads - count of threads (0 - hardware concurrency)
+         */
+        static void save_parallel(size_t                                                  count,
+                                  const std::function<StringT(size_t, TruevisionImage&)>& producer,
+                                  bool                                                    rle     = false,
+                                  size_t                                                  threads = 0) {
+            if (threads == 0)
+                threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+            auto next  = std::atomic<size_t>(0);
+            auto error = std::exception_ptr();
+            auto mutex = std::mutex();
+
+            auto job = [&] {
+                auto image  = TruevisionImage();
+                auto buffer = std::vector<uint8_t>();
+
+                try {
+                    for (size_t i = next++; i < count; i = next++) {
+                        auto path = producer(i, image);
+                        image.encode(buffer, rle);
+                        write_file(path, buffer);
+                    }
+                }
+                catch (...) {
+                    auto lock = std::lock_guard(mutex);
+                    if (!error)
+                        error = std::current_exception();
+                    next = count;
+                }
+            };
+
+            auto workers = std::vector<std::thread>();
+            for (size_t i = 0; i < std::min(threads, count); ++i)
+                workers.emplace_back(job);
+
+            for (auto& th : workers)
+                th.join();
+
+            if (error)
+                std::rethrow_exception(error);
         }
 
         operator bool() const {
@@ -207,11 +351,17 @@ namespace fft {
         }
 
         void init(Type type, size_t width, size_t height) {
-            delete [] _data;
+            auto new_size = width * height * bytes_per_pixel(type);
+
+            // Reuse buffer of the same size (e.g. in save_parallel())
+            if (!_data || new_size != _width * _height * bytes_per_pixel(_type)) {
+                delete [] _data;
+                _data = new uint8_t[new_size];
+            }
+
             _type   = type;
             _width  = width;
             _height = height;
-            _data = new uint8_t[_width * _height * bytes_per_pixel(_type)];
         }
 
         void from_color_map(const ColorMap8& map) {
@@ -363,6 +513,53 @@ namespace fft {
             return _data + (i * _width * bytes_per_pixel(_type));
         }
 
+    private:
+        static constexpr size_t  HEADER_SIZE = 18;
+        static constexpr size_t  FOOTER_SIZE = 26;
+        static constexpr uint8_t RLE_FLAG    = 8;
+
+        // Packets don't cross scanlines (TGA 2.0 recommendation)
+        static void encode_rle_row(const uint8_t* row, size_t width, size_t pixel_size, std::vector<uint8_t>& out) {
+            auto same = [row, pixel_size](size_t a, size_t b) {
+                return std::memcmp(row + a * pixel_size, row + b * pixel_size, pixel_size) == 0;
+            };
+
+            for (size_t x = 0; x < width;) {
+                size_t run = 1;
+                while (x + run < width && run < 128 && same(x, x + run))
+                    ++run;
+
+                if (run > 1) {
+                    // Run-length packet
+                    out.push_back(static_cast<uint8_t>(0x80U | (run - 1)));
+                    out.insert(out.end(), row + x * pixel_size, row + (x + 1) * pixel_size);
+                    x += run;
+                }
+                else {
+                    // Raw packet, ends before next run of 2+ equal pixels
+                    size_t raw = 1;
+                    while (x + raw < width && raw < 128 && !(x + raw + 1 < width && same(x + raw, x + raw + 1)))
+                        ++raw;
+
+                    out.push_back(static_cast<uint8_t>(raw - 1));
+                    out.insert(out.end(), row + x * pixel_size, row + (x + raw) * pixel_size);
+                    x += raw;
+                }
+            }
+        }
+
+        static void write_file(const StringT& path, const std::vector<uint8_t>& buffer) {
+            auto os = std::ofstream(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+            if (!os.is_open())
+                throw TtfException("Can't open file '" + path + "'");
+
+            os.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+            if (!os)
+                throw TtfException("TruevisionImage::write_file(): can't write file '" + path + "'");
+        }
+
     private:
         uint8_t* _data = nullptr;
         size_t _width  = 0;